@@ -3,14 +3,23 @@
 
 #include "QtWin/QWLogger.h"
 #include "QtWin/QWSettings.h"
+#include "QtWin/QWThemeSnapshot.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QList>
+#include <QPromise>
 #include <QString>
 
+#include <memory>
+#include <mutex>
+
 QWLOGGER(qtwinDefaultLogger)
 
 namespace QtWin {
 class QWSettings;
+class QWThemeManager;
 }//前向声明
 
 namespace QtWin {
@@ -20,6 +29,26 @@ class QWApplication : public QApplication {
     Q_PROPERTY(bool isDarkMode READ isDarkMode WRITE setDarkMode NOTIFY darkModeChanged)
 
 public:
+    /**
+     * @brief 日志与设置系统的初始化方式。
+     */
+    enum InitMode {
+        Sequential = 1, // 在构造函数中依次完成（默认）
+        Concurrent = 2, // 在工作线程中初始化，首次访问设置或创建窗口时等待完成
+        Deferred = 3    // 推迟到事件循环开始后，首次访问设置时提前完成
+    };
+    Q_ENUM(InitMode)
+
+    /**
+     * @brief 一个启动阶段的耗时，时间均从 QWApplication 构造开始计算。
+     */
+    struct StartupPhase {
+        QString name;
+        qint64 startNsecs;
+        qint64 nsecs;
+        bool worker; // 是否在工作线程中执行
+    };
+
     /**
      * @brief 构造函数。
      * @param argc 命令行参数计数。
@@ -28,17 +57,65 @@ public:
      * @param appName 应用程序名称，用于 QSettings 和标准路径。
      * @param appVersion 应用程序版本号。
      * @param isDarkMode 初始的深色模式状态。
+     * @param initMode 日志与设置系统的初始化方式。
      */
     QWApplication(int &argc, char **argv,
                 const QString &orgName,
                 const QString &appName,
                 const QString &appVersion,
-                bool isDarkMode = false);
+                bool isDarkMode = false,
+                InitMode initMode = Sequential);
+    ~QWApplication() override;
 
     static QWApplication* instance();
+
+    /**
+     * @brief 获取设置系统。Concurrent / Deferred 模式下尚未初始化完成时先等待或立即完成初始化。
+     *
+     * 可以在任意线程中调用：初始化只在 GUI 线程中完成，其他线程等待 GUI 线程完成初始化
+     * （最迟在第一次事件循环中），不会接触对象树。
+     */
     QWSettings* settings() const;
+
+    /**
+     * @brief 获取在所有窗口之间共享 QPalette 的主题管理器。
+     */
+    QWThemeManager* themeManager() const;
+
+    /**
+     * @brief 获取启动时从设置中读取的主题快照。
+     *
+     * 快照有效时已经放入 QWPaletteCache 与主题管理器，QWWindow 在首次显示前
+     * 直接采用它的种子颜色与色调，第一帧就是用户保存的主题。
+     * Deferred 模式下在 GUI 线程中初始化完成前返回无效快照，窗口使用默认主题；
+     * 在其他线程中调用时与 settings() 一样等待初始化完成。
+     */
+    const QWThemeSnapshot& themeSnapshot() const;
+
+    /**
+     * @brief 更新主题快照并保存到设置，下次启动时使用。只能在 GUI 线程中调用。
+     * @param snapshot 新的快照，无效快照会清除已保存的快照
+     */
+    void setThemeSnapshot(const QWThemeSnapshot& snapshot);
+
     bool isDarkMode() const;
 
+    InitMode initMode() const;
+
+    /**
+     * @brief 获取已完成的启动阶段：paths、logger、settings、themeManager、themeSnapshot，
+     * Concurrent 模式下主线程等待工作线程的 wait，以及首个窗口显示时的 firstWindow。只能在 GUI 线程中调用。
+     */
+    QList<StartupPhase> startupPhases() const;
+
+    /**
+     * @brief 记录首个窗口显示的时间。初始化也完成后，通过 qtwin.core.app 日志类别
+     * （Info 级别）输出一次各阶段耗时。
+     *
+     * QWWindow 首次显示时自动调用；只使用其他顶层窗口的应用可以自行调用，只有第一次调用有效。
+     */
+    void markFirstWindowShown();
+
 public slots:
     void setDarkMode(bool dark);
     void toggleDarkMode();
@@ -47,8 +124,28 @@ signals:
     void darkModeChanged(bool isDark);
 
 private:
+    struct StartupServices;
+
+    void completeStartup();
+    void finishStartup();
+    void recordPhase(const QString &name, qint64 startNsecs, bool worker = false);
+    void reportStartup();
+
     bool m_isDarkMode;
     QWSettings* m_settings;
+    QWThemeManager* m_themeManager;
+    QWThemeSnapshot m_themeSnapshot;
+
+    InitMode m_initMode;
+    QElapsedTimer m_startupClock;
+    std::shared_ptr<StartupServices> m_startupServices; // 初始化完成后为空
+    QFuture<void> m_startupTask;                       // Concurrent 模式下的工作线程任务
+    std::once_flag m_startupOnce;                       // finishStartup 只在 GUI 线程中执行一次
+    QPromise<void> m_startupDone;                       // finishStartup 完成后结束
+    QFuture<void> m_startupReady;                       // 其他线程通过它等待初始化完成
+    QList<StartupPhase> m_startupPhases;
+    qint64 m_firstWindowNsecs;                          // -1 表示首个窗口尚未显示
+    bool m_startupReported;
 };
 
 } // namespace QtWin
@@ -0,0 +1,91 @@
+#ifndef QWICONTINTER_H
+#define QWICONTINTER_H
+
+#include "QtWin/QWPalette.h"
+
+#include <QCache>
+#include <QColor>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QString>
+
+namespace QtWin {
+
+class QWWindow;
+
+/**
+ * @class QWIconTinter
+ * @brief 把单色图标（alpha 遮罩）按窗口调色板的色彩角色和色调着色。
+ *
+ * 着色使用 SIMD 内核逐行处理，不经过 QImage::pixel/setPixel。
+ * 结果按 图标 id + 色彩角色 + 色调 + 设备像素比 缓存为 QPixmap，
+ * 窗口的主题（深浅色）、种子颜色或色调变化时整体失效。
+ *
+ * 只能在 GUI 线程中使用；tinted() 是纯函数，可以在任意线程调用。
+ */
+class QWIconTinter : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 创建绑定到 window 的着色器，作为 window 的子对象。
+     */
+    explicit QWIconTinter(QWWindow* window);
+    ~QWIconTinter() override;
+
+    /**
+     * @brief 获取着色后的图标，命中缓存时不读取 mask。
+     * @param id 图标的唯一标识（通常是资源路径）
+     * @param mask 图标遮罩，只使用 alpha 通道；设备像素比取自 mask
+     * @param role 色彩角色
+     * @param tone 色调，-1 表示窗口当前主题的默认色调
+     */
+    QPixmap pixmap(const QString& id, const QImage& mask, QWPalette::QWColor role, int tone = -1);
+    QPixmap pixmap(const QString& id, const QPixmap& mask, QWPalette::QWColor role, int tone = -1);
+
+    /**
+     * @brief 设置缓存容量（KB），默认 8192。
+     */
+    void setCacheLimit(int kilobytes);
+    int cacheLimit() const;
+
+    /**
+     * @brief 当前缓存的图标数。
+     */
+    int size() const;
+
+    /**
+     * @brief 清空缓存。主题变化时会自动调用。
+     */
+    void clear();
+
+    /**
+     * @brief 用 color 填充 mask 的不透明部分。
+     * 输出为 ARGB32_Premultiplied，每个像素为预乘后的 color 再乘以 mask 的 alpha，
+     * 尺寸与设备像素比与 mask 相同。Alpha8、ARGB32、ARGB32_Premultiplied
+     * 直接读取，其他格式先转换。
+     */
+    static QImage tinted(const QImage& mask, const QColor& color);
+
+private:
+    struct Key {
+        QString id;
+        int role;
+        int tone;
+        qreal devicePixelRatio;
+
+        bool operator==(const Key& other) const;
+    };
+    friend size_t qHash(const Key& key, size_t seed) noexcept;
+
+    int resolveTone(int tone) const;
+    QPixmap store(const Key& key, const QImage& mask);
+
+    QWWindow* m_window;
+    QCache<Key, QPixmap> m_cache; // 代价以 KB 计
+};
+
+} // namespace QtWin
+
+#endif
@@ -2,7 +2,14 @@
 #define QWPALETTE_H
 
 #include <QColor>
+#include <QFuture>
 #include <QImage>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+class QIODevice;
 
 namespace QtWin{
     /***
@@ -22,21 +29,99 @@ namespace QtWin{
         RGBColor(QColor qcolor);
     };
 
+    /***
+     * @brief numeric precision of the color conversion kernels
+     * 
+     * Maximum 8-bit output error of HCT2RGB against Exact, verified over the
+     * HCT of all 16.7M sRGB colors by QtWinColorTests:
+     *   Exact  double, the reference
+     *   Float  single precision float, at most 1 per channel
+     *   Fixed  Q16.16 fixed-point integer math with lookup tables, at most 1 per channel
+     * RGB2HCT -> HCT2RGB round trips with the same precision reproduce the
+     * input within 1 per channel for every variant.
+     * 
+     * Use Exact for palette seeds, Float or Fixed for per-pixel image work.
+     */
+    enum class ColorPrecision {
+        Exact,
+        Float,
+        Fixed
+    };
+
     /***
      * @brief convert sRGB to HCT
      * 
-     * @param rgb an sRGB color struct
+     * @param rgb an sRGB color struct, channels are clamped to [0,255]
+     * @param precision numeric precision of the conversion
      * @return an HCT color struct
      */
-    HCTColor RGB2HCT(const RGBColor& rgb);
+    HCTColor RGB2HCT(const RGBColor& rgb, ColorPrecision precision = ColorPrecision::Exact);
+
+    /***
+     * @brief gamut mapping strategy used when an HCT color falls outside sRGB
+     */
+    enum class GamutMapping {
+        Clip,         // clamp linear RGB channels (legacy, may shift hue and tone)
+        ReduceChroma  // keep hue and tone, reduce chroma to the sRGB boundary
+    };
 
     /***
      * @brief convert HCT to sRGB
      * 
      * @param hct an HCT color struct
+     * @param mapping how to bring out-of-gamut colors back into sRGB
+     * @param precision numeric precision of the conversion
      * @return an sRGB color struct
      */
-    RGBColor HCT2RGB(const HCTColor& hct);
+    RGBColor HCT2RGB(const HCTColor& hct, GamutMapping mapping = GamutMapping::Clip,
+                    ColorPrecision precision = ColorPrecision::Exact);
+
+    /***
+     * @brief convert a batch of sRGB colors to HCT
+     * 
+     * Results are identical to calling the scalar RGB2HCT per element.
+     * 
+     * @param rgb source colors
+     * @param hct destination, must hold count elements
+     * @param count number of colors
+     * @param precision numeric precision of the conversion
+     */
+    void RGB2HCT(const RGBColor* rgb, HCTColor* hct, qsizetype count,
+                ColorPrecision precision = ColorPrecision::Exact);
+
+    /***
+     * @brief convert a batch of HCT colors to sRGB
+     * 
+     * @param hct source colors
+     * @param rgb destination, must hold count elements
+     * @param count number of colors
+     * @param mapping how to bring out-of-gamut colors back into sRGB
+     * @param precision numeric precision of the conversion
+     */
+    void HCT2RGB(const HCTColor* hct, RGBColor* rgb, qsizetype count,
+                GamutMapping mapping = GamutMapping::Clip,
+                ColorPrecision precision = ColorPrecision::Exact);
+
+    /***
+     * @brief get the maximum chroma sRGB can display for a hue and tone
+     * 
+     * Backed by a precomputed hue x tone table (built once on first use),
+     * so the result is an interpolated estimate of the sRGB boundary.
+     * 
+     * @param hue hue in degrees
+     * @param tone tone in [0,100]
+     * @return estimated maximum chroma
+     */
+    double maxChroma(double hue, double tone);
+
+    /***
+     * @brief which side of the background QWPalette::toneForContrast searches
+     */
+    enum class ContrastSearch {
+        Auto,    // darker on light backgrounds (tone >= 50), lighter on dark ones, then the other side
+        Darker,  // only tones darker than the background
+        Lighter  // only tones lighter than the background
+    };
 
     /***
      * @brief QtWinPalette
@@ -46,10 +131,15 @@ namespace QtWin{
             QWPalette();
             QWPalette(RGBColor rgb);
             QWPalette(HCTColor hct);
+            QWPalette(const QWPalette& other);
+            QWPalette& operator=(const QWPalette& other);
 
             void setSeedColor(RGBColor rgb);
             void setSeedColor(HCTColor hct);
 
+            void setGamutMapping(GamutMapping mapping);
+            GamutMapping gamutMapping() const;
+
             enum QWColor{
                 mainColor     = 0,
                 subColor      = 1,
@@ -63,18 +153,165 @@ namespace QtWin{
             QColor getQColor(QWColor n,int tone) const;
             RGBColor getRGBColor(QWColor n,int tone) const;
 
+            /***
+             * @brief WCAG relative luminance of a role at a tone
+             * 
+             * Read from a per-role table over tones 0 to 100, built from the
+             * gamut-mapped sRGB colors on first use (thread-safe) and rebuilt
+             * after setSeedColor or setGamutMapping.
+             * 
+             * @param n color role
+             * @param tone tone, clamped to [0,100]
+             * @return relative luminance in [0,1]
+             */
+            double relativeLuminance(QWColor n,int tone) const;
+
+            /***
+             * @brief find the tone of a role that reaches a contrast ratio against a background
+             * 
+             * Binary search over the luminance table, no color conversions.
+             * Returns the tone closest to the background that reaches ratio on
+             * the searched side, or the end of that side (0 or 100) with the
+             * highest contrast if none does.
+             * 
+             * @param n color role of the foreground
+             * @param backgroundTone tone of the background
+             * @param ratio WCAG contrast ratio to reach, e.g. 4.5 for normal text
+             * @param backgroundRole color role of the background
+             * @param search which side of the background to search
+             * @return foreground tone in [0,100]
+             */
+            int toneForContrast(QWColor n,int backgroundTone,double ratio,QWColor backgroundRole,
+                                ContrastSearch search = ContrastSearch::Auto) const;
+
+            /***
+             * @brief same as above, with the background in the same role and ContrastSearch::Auto
+             */
+            int toneForContrast(QWColor n,int backgroundTone,double ratio) const;
+
         private:
+            struct LuminanceTable {
+                double value[5][101];
+            };
+            const LuminanceTable& luminanceTable() const;
+
             HCTColor basicColor;
             HCTColor palette[5];
+            GamutMapping mapping = GamutMapping::Clip;
+            mutable std::shared_ptr<const LuminanceTable> luminance; // built lazily, accessed with std::atomic_load/store
 
     };
 
+    /***
+     * @brief how extractSeedColor reduces an image before counting colors
+     */
+    enum class SeedSampling {
+        Smooth,  // convertToFormat + SmoothTransformation scale (legacy, allocates image copies)
+        Strided, // read the center pixel of each sample cell in place
+        Box      // alpha-weighted average of every pixel in each sample cell, read in place
+    };
+
+    /***
+     * @brief how extractSeedColor turns the color histogram into seed colors
+     */
+    enum class SeedQuantizer {
+        Histogram, // rank the histogram bins by population x chroma (legacy)
+        KMeans     // weighted k-means in CIELAB over the populated bins, then rank the clusters
+    };
+
+    /***
+     * @brief options for extractSeedColor
+     */
+    struct SeedExtractionOptions {
+        int maxDimension = 256; // longer edge of the sample grid, 0 samples every pixel
+        bool parallel = false;  // split the histogram pass across QThreadPool::globalInstance()
+        SeedSampling sampling = SeedSampling::Smooth;
+        int binBits = 4;        // histogram bits per channel: 4 (4096 bins), 5 or 6 (sparse)
+        SeedQuantizer quantizer = SeedQuantizer::Histogram;
+    };
+
     /***
      * @brief extract the main color from an image
      * @param image image in QImage
      * @param colorSet HCTColor vector to get returns
      */
     void extractSeedColor(const QImage& image, std::vector<HCTColor>& colorSet);
+
+    /***
+     * @brief extract the main color from an image with explicit sampling options
+     * 
+     * With parallel set, large images are split into scanline ranges that run
+     * on the global thread pool, each worker counting into a private histogram
+     * that is merged at the end. Small images always run on the calling thread.
+     * The result is identical to the serial pass.
+     * 
+     * @param image image in QImage
+     * @param colorSet HCTColor vector to get returns
+     * @param options sampling resolution and threading
+     */
+    void extractSeedColor(const QImage& image, std::vector<HCTColor>& colorSet,
+                        const SeedExtractionOptions& options);
+
+    /***
+     * @brief decode an image file at reduced resolution and extract its main colors
+     * 
+     * The image is never fully decoded when the format can scale while
+     * decoding (JPEG scales in the DCT domain): QImageReader::setScaledSize
+     * is set to the sample grid, so peak memory is bounded by
+     * options.maxDimension instead of the file's resolution. Other formats
+     * are decoded once and sampled in place.
+     * 
+     * @param path image file path
+     * @param colorSet HCTColor vector to get returns, cleared on failure
+     * @param options sampling resolution and threading
+     * @return false if the file cannot be read or decoded
+     */
+    bool extractSeedColorFromFile(const QString& path, std::vector<HCTColor>& colorSet,
+                                const SeedExtractionOptions& options = SeedExtractionOptions());
+
+    /***
+     * @brief decode an image from a device at reduced resolution and extract its main colors
+     * 
+     * Same as extractSeedColorFromFile, reading from an open QIODevice.
+     * 
+     * @param device readable device positioned at the start of the image
+     * @param colorSet HCTColor vector to get returns, cleared on failure
+     * @param options sampling resolution and threading
+     * @return false if the data cannot be decoded
+     */
+    bool extractSeedColor(QIODevice* device, std::vector<HCTColor>& colorSet,
+                        const SeedExtractionOptions& options = SeedExtractionOptions());
+
+    /***
+     * @brief extract the main colors of an image on a background thread
+     * 
+     * Runs on a dedicated thread pool and returns immediately, so it is safe
+     * to call from the GUI thread; watch the future with QFutureWatcher.
+     * The work stops cooperatively between scanline chunks when the future is
+     * canceled. A newer request on the same channel cancels the older one
+     * if it has not finished yet, so only the latest wallpaper or cover is
+     * extracted. Requests without a channel share the default channel.
+     * 
+     * A canceled or superseded future finishes without a result.
+     * 
+     * @param image image in QImage, shared implicitly, not copied
+     * @param options sampling resolution and threading
+     * @param channel coalescing key, requests on different channels are independent
+     * @return future holding the extracted colors
+     */
+    QFuture<std::vector<HCTColor>> extractSeedColorAsync(const QImage& image,
+                                                        const SeedExtractionOptions& options = SeedExtractionOptions(),
+                                                        const QString& channel = QString());
+
+    /***
+     * @brief decode a file and extract its main colors on a background thread
+     * 
+     * Same as extractSeedColorAsync, decoding with extractSeedColorFromFile.
+     * The future also finishes without a result if the file cannot be decoded.
+     */
+    QFuture<std::vector<HCTColor>> extractSeedColorFromFileAsync(const QString& path,
+                                                                const SeedExtractionOptions& options = SeedExtractionOptions(),
+                                                                const QString& channel = QString());
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+#ifndef QWPALETTECACHE_H
+#define QWPALETTECACHE_H
+
+#include "QtWin/QWPalette.h"
+
+#include <QColor>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <list>
+
+namespace QtWin {
+
+/**
+ * @class QWToneTable
+ * @brief 不可变的色调表：5 个色彩角色 × 0~100 色调预先转换好的 sRGB 颜色。
+ *
+ * 构造时一次性完成全部 HCT -> sRGB 转换，之后的查询只是数组访问。
+ * 超出 [0,100] 的色调会被限定到边界，与 HCT2RGB 的行为一致。
+ */
+class QWToneTable {
+public:
+    static constexpr int kRoleCount = 5;
+    static constexpr int kToneCount = 101;
+
+    explicit QWToneTable(const QWPalette& palette);
+
+    /**
+     * @brief 由已经转换好的颜色构建，不做任何颜色转换（例如从主题快照恢复）。
+     * @param values kRoleCount × kToneCount 个颜色，按角色、色调顺序排列
+     */
+    explicit QWToneTable(const QRgb* values);
+
+    QRgb rgb(QWPalette::QWColor role, int tone) const;
+    QColor color(QWPalette::QWColor role, int tone) const;
+
+    /**
+     * @brief 全部 kRoleCount × kToneCount 个颜色，按角色、色调顺序排列。
+     */
+    const QRgb* data() const;
+
+private:
+    QRgb m_table[kRoleCount][kToneCount];
+};
+
+/**
+ * @class QWPaletteCache
+ * @brief 进程级、线程安全的调色板缓存。
+ *
+ * 以 种子颜色 + 浅/深色调 + 色域映射方式 为键，返回引用计数的不可变
+ * QWPalette 与 QWToneTable。多个窗口使用相同的主题配置时共享同一份对象，
+ * 命中时只需一次哈希查找。调色板与色调设置无关，只改变色调的请求按 种子 + 色域映射
+ * 再做一次哈希查找，共享已有的调色板与色调表。超出容量时按最近最少使用（LRU）淘汰。
+ */
+class QWPaletteCache {
+public:
+    struct Key {
+        QRgb seed;
+        int lightTone;
+        int darkTone;
+        GamutMapping mapping;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct Entry {
+        QSharedPointer<const QWPalette> palette;
+        QSharedPointer<const QWToneTable> tones;
+    };
+
+    /**
+     * @brief 获取全局缓存实例。
+     */
+    static QWPaletteCache& instance();
+
+    /**
+     * @brief 获取指定主题配置的调色板，未命中时构建并放入缓存。
+     * @param seed 种子颜色（忽略 alpha）
+     * @param lightTone 浅色模式色调
+     * @param darkTone 深色模式色调
+     * @param mapping 色域映射方式，作为调色板变体的一部分参与缓存键
+     * @return 共享的调色板与色调表
+     */
+    Entry acquire(const QColor& seed, int lightTone, int darkTone,
+                GamutMapping mapping = GamutMapping::Clip);
+
+    /**
+     * @brief 放入预先构建好的调色板与色调表（例如从主题快照恢复）。
+     * 已有相同键的条目时保留已有对象，以保证共享。
+     * @return 缓存中的条目
+     */
+    Entry insert(const QColor& seed, int lightTone, int darkTone, const Entry& entry,
+                GamutMapping mapping = GamutMapping::Clip);
+
+    /**
+     * @brief 设置缓存容量（条目数），缩小时立即淘汰多余条目。
+     */
+    void setCapacity(int capacity);
+    int capacity() const;
+
+    /**
+     * @brief 当前缓存的条目数。
+     */
+    int size() const;
+
+    /**
+     * @brief 清空缓存。已经分发出去的对象由引用计数维持，不受影响。
+     */
+    void clear();
+
+private:
+    QWPaletteCache() = default;
+    Q_DISABLE_COPY(QWPaletteCache)
+
+    void add(const Key& key, const Entry& entry);
+    void trim();
+
+    struct Node {
+        Entry entry;
+        std::list<Key>::iterator lruPos;
+    };
+
+    // 调色板本身的键：不含色调
+    struct PaletteKey {
+        QRgb seed;
+        GamutMapping mapping;
+
+        bool operator==(const PaletteKey& other) const;
+    };
+    friend size_t qHash(const PaletteKey& key, size_t seed) noexcept;
+
+    struct SharedPalette {
+        Entry entry;
+        int keys; // 引用它的 m_entries 键数，为 0 时移除
+    };
+
+    mutable QMutex m_mutex;
+    QHash<Key, Node> m_entries;
+    QHash<PaletteKey, SharedPalette> m_palettes; // 按种子 + 色域映射索引，与 m_entries 同步淘汰
+    std::list<Key> m_lru; // 头部为最近使用
+    int m_capacity = 32;
+};
+
+size_t qHash(const QWPaletteCache::Key& key, size_t seed = 0) noexcept;
+
+} // namespace QtWin
+
+#endif
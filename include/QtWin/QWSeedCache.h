@@ -0,0 +1,124 @@
+#ifndef QWSEEDCACHE_H
+#define QWSEEDCACHE_H
+
+#include "QtWin/QWPalette.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <vector>
+
+class QIODevice;
+
+namespace QtWin {
+
+/**
+ * @class QWSeedCache
+ * @brief 进程级、线程安全的种子颜色持久化缓存。
+ *
+ * 以 文件路径 + 修改时间 + 大小（或图像内容哈希）+ 提取参数 为键，
+ * 保存 extractSeedColor 的结果。命中时直接返回颜色，完全不解码图像。
+ *
+ * 结果以紧凑的二进制记录追加写入 AppDataLocation 目录下的 seedcache.bin，
+ * 程序重启后依然有效；内存中只保存 键 -> 文件偏移 的索引，
+ * 前面再加一层按最近最少使用（LRU）淘汰的结果缓存。
+ */
+class QWSeedCache {
+public:
+    using Key = QByteArray; // 20 字节 SHA-1
+
+    /**
+     * @brief 获取全局缓存实例。
+     */
+    static QWSeedCache& instance();
+
+    /**
+     * @brief 提取图像文件的种子颜色，命中缓存时不解码图像。
+     * @param path 图像文件路径
+     * @param colorSet 提取结果
+     * @param options 提取参数，参与缓存键
+     * @return 文件无法读取或解码时返回 false
+     */
+    bool extractFromFile(const QString& path, std::vector<HCTColor>& colorSet,
+                         const SeedExtractionOptions& options = SeedExtractionOptions());
+
+    /**
+     * @brief 按内容哈希提取设备中图像的种子颜色，命中缓存时不解码图像。
+     * 适用于没有稳定路径的数据，例如内嵌在音频文件中的专辑封面。
+     * @param device 可读设备，会读取全部剩余数据
+     * @param colorSet 提取结果
+     * @param options 提取参数，参与缓存键
+     * @return 数据无法解码时返回 false
+     */
+    bool extractFromDevice(QIODevice* device, std::vector<HCTColor>& colorSet,
+                           const SeedExtractionOptions& options = SeedExtractionOptions());
+
+    /**
+     * @brief 由文件路径、修改时间和大小计算缓存键，文件不存在时返回空键。
+     */
+    static Key fileKey(const QString& path, const SeedExtractionOptions& options = SeedExtractionOptions());
+
+    /**
+     * @brief 由图像的编码数据计算缓存键。
+     */
+    static Key contentKey(const QByteArray& data, const SeedExtractionOptions& options = SeedExtractionOptions());
+
+    /**
+     * @brief 查询缓存。
+     * @return 命中返回 true
+     */
+    bool lookup(const Key& key, std::vector<HCTColor>& colorSet);
+
+    /**
+     * @brief 写入缓存，同时追加到磁盘文件。
+     */
+    void insert(const Key& key, const std::vector<HCTColor>& colorSet);
+
+    /**
+     * @brief 设置磁盘文件路径，默认 AppDataLocation/seedcache.bin。
+     * 空路径表示只使用内存缓存。
+     */
+    void setFilePath(const QString& filePath);
+    QString filePath() const;
+
+    /**
+     * @brief 设置内存 LRU 的容量（条目数）。
+     */
+    void setMemoryCapacity(int capacity);
+    int memoryCapacity() const;
+
+    /**
+     * @brief 磁盘中保存的条目数。
+     */
+    int size() const;
+
+    /**
+     * @brief 清空内存缓存并删除磁盘文件。
+     */
+    void clear();
+
+private:
+    QWSeedCache();
+    Q_DISABLE_COPY(QWSeedCache)
+
+    bool openFile();
+    bool readRecord(qint64 offset, std::vector<HCTColor>& colorSet);
+    void compact();
+
+    mutable QMutex m_mutex;
+    QString m_filePath;
+    QFile m_file;
+    bool m_opened = false;
+    qint64 m_recordCount = 0;                // 文件中的记录数（包括被覆盖的旧记录）
+    qint64 m_compactRetryAt = 0;             // 压缩失败后，记录数达到该值前不再重试
+    QHash<Key, qint64> m_index;               // 键 -> 记录在文件中的偏移
+    QCache<Key, std::vector<HCTColor>> m_lru; // 最近使用的结果
+};
+
+} // namespace QtWin
+
+#endif
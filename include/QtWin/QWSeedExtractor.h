@@ -0,0 +1,105 @@
+#ifndef QWSEEDEXTRACTOR_H
+#define QWSEEDEXTRACTOR_H
+
+#include "QtWin/QWPalette.h"
+
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace QtWin {
+
+/**
+ * @class QWSeedExtractor
+ * @brief 面向大量图片（如媒体库缩略图）的批量种子颜色提取引擎。
+ *
+ * 以流水线方式处理：调用线程顺序读取文件数据，放入有界队列；
+ * 有界工作线程池从队列中取出数据，完成解码（尽量在解码时缩小）、
+ * 直方图统计与评分。队列满时读取端阻塞（背压），内存占用与图片数量无关。
+ *
+ * 直方图缓冲区在工作线程之间复用，不会为每张图片重新分配。
+ * 可选地先查询 QWSeedCache，命中的图片不读取也不解码。
+ */
+class QWSeedExtractor {
+public:
+    /**
+     * @brief 单张图片的提取结果。
+     */
+    struct Result {
+        int index = -1;                  // 在 paths 中的下标
+        QString path;
+        bool ok = false;                 // 读取或解码失败时为 false
+        bool cached = false;             // 结果来自 QWSeedCache
+        std::vector<HCTColor> colors;
+    };
+
+    using ResultCallback = std::function<void(const Result& result)>;
+    using ProgressCallback = std::function<void(int finished, int total)>;
+
+    explicit QWSeedExtractor(const SeedExtractionOptions& options = SeedExtractionOptions());
+    ~QWSeedExtractor();
+
+    /**
+     * @brief 设置工作线程数，默认 QThread::idealThreadCount()。
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const;
+
+    /**
+     * @brief 设置已读取、等待解码的图片数上限，默认工作线程数的两倍。
+     */
+    void setQueueDepth(int depth);
+    int queueDepth() const;
+
+    /**
+     * @brief 是否通过 QWSeedCache 查询和保存结果，默认开启。
+     */
+    void setUseCache(bool useCache);
+    bool useCache() const;
+
+    /**
+     * @brief 提取全部图片的种子颜色，阻塞直到完成或被取消。
+     *
+     * 每张图片完成后立即回调，回调在工作线程或调用线程中执行，
+     * 但同一时刻只会有一个回调在运行，无需额外加锁。
+     * 结果的完成顺序不一定与 paths 的顺序一致，请使用 Result::index。
+     * 界面代码应在后台线程中调用，并把结果转发回 GUI 线程。
+     *
+     * @param paths 图片文件路径
+     * @param onResult 每张图片的结果
+     * @param onProgress 进度（已完成数, 总数）
+     * @return 成功提取的图片数
+     */
+    int extractAll(const QStringList& paths, const ResultCallback& onResult,
+                   const ProgressCallback& onProgress = ProgressCallback());
+
+    /**
+     * @brief 请求停止正在进行的 extractAll，线程安全。
+     * 已经开始解码的图片会在下一个扫描行块之前停止，未开始的图片不再回调。
+     * 只作用于当前（或最近一次）的 extractAll，之后开始的 extractAll 不受影响。
+     */
+    void cancel();
+
+private:
+    Q_DISABLE_COPY(QWSeedExtractor)
+
+    class HistogramPool;
+
+    SeedExtractionOptions m_options;
+    int m_maxWorkers;
+    int m_queueDepth = 0; // 0 表示工作线程数的两倍
+    bool m_useCache = true;
+    std::atomic<quint64> m_run{0};         // 最近一次 extractAll 的编号
+    std::atomic<quint64> m_canceledRun{0}; // 编号不大于它的运行已被取消
+    QThreadPool m_pool;
+    std::unique_ptr<HistogramPool> m_histograms;
+};
+
+} // namespace QtWin
+
+#endif
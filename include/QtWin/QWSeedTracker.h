@@ -0,0 +1,105 @@
+#ifndef QWSEEDTRACKER_H
+#define QWSEEDTRACKER_H
+
+#include "QtWin/QWPalette.h"
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+#include <vector>
+
+namespace QtWin {
+
+/**
+ * @class QWSeedTracker
+ * @brief 逐帧跟踪视频预览或动态壁纸的种子颜色。
+ *
+ * 在帧之间保留 4096 个桶的直方图，而不是每帧重新量化整幅图像：
+ * 每帧只重新读取一部分稀疏采样点，与该点上一次读到的桶比较，
+ * 只更新发生变化的桶。直方图按指数移动平均做时间平滑，
+ * 只有当平滑后的变化足以改变入选颜色或其顺序时才重新评分。
+ *
+ * 不是线程安全的，同一实例应只在一个线程中使用（通常是解码线程）。
+ */
+class QWSeedTracker {
+public:
+    QWSeedTracker();
+
+    /**
+     * @brief 设置采样点数，默认 4096。修改后下一帧重新开始统计。
+     */
+    void setSampleCount(int count);
+    int sampleCount() const;
+
+    /**
+     * @brief 设置每个采样点每隔多少帧重新读取一次，默认 4。
+     * 每帧按行轮流读取 1/frames 的采样点；1 表示每帧读取全部采样点。
+     */
+    void setRefreshInterval(int frames);
+    int refreshInterval() const;
+
+    /**
+     * @brief 设置时间平滑系数，即新一帧所占的权重，范围 (0, 1]，默认 0.25。
+     * 1 表示不平滑，结果只取决于当前采样。
+     */
+    void setSmoothing(double factor);
+    double smoothing() const;
+
+    /**
+     * @brief 送入一帧。帧尺寸变化时重新开始统计。
+     * @return 种子颜色发生变化时返回 true
+     */
+    bool update(const QImage& frame);
+
+    /**
+     * @brief 送入一帧，调用方保证只有 changed 区域与上一帧不同。
+     * 立即重新读取区域内的全部采样点，区域外的采样点不读取。
+     * 适用于只重绘局部的动态壁纸。
+     * @return 种子颜色发生变化时返回 true
+     */
+    bool update(const QImage& frame, const QRect& changed);
+
+    /**
+     * @brief 当前的种子颜色，含义与 extractSeedColor 的结果相同。
+     */
+    const std::vector<HCTColor>& colors() const;
+
+    /**
+     * @brief 丢弃历史，下一帧重新开始统计。
+     */
+    void reset();
+
+    int frameCount() const;   // 已送入的帧数
+    int scoringCount() const; // 实际重新评分的次数
+
+private:
+    bool restart(const QImage& frame);
+    bool refreshRow(const QImage& frame, int row, int first, int last);
+    bool integrate(bool sampled);
+    bool rescore();
+
+    int m_sampleCount = 4096;
+    int m_refreshInterval = 4;
+    double m_smoothing = 0.25;
+
+    QSize m_frameSize;
+    std::vector<int> m_columns;     // 采样点的 x 坐标
+    std::vector<int> m_rows;        // 采样点的 y 坐标
+    std::vector<quint16> m_keys;    // 每个采样点上一次读到的桶
+    std::vector<quint16> m_scratch; // 一行采样点的新读数
+    std::vector<int> m_counts;      // 各桶的采样点数，最后一项为透明像素
+    std::vector<double> m_smoothed; // 时间平滑后的各桶比例
+    std::vector<double> m_scored;   // 上次评分时的 m_smoothed
+    double m_margin = 0.0;          // 上次评分的裕量
+    bool m_grayFallback = false;
+    bool m_settled = false;         // 平滑结果已收敛到当前采样
+    int m_phase = 0;                // 本帧轮到的采样行
+    int m_frames = 0;
+    int m_scorings = 0;
+    std::vector<HCTColor> m_colors;
+};
+
+} // namespace QtWin
+
+#endif
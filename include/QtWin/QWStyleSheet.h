@@ -0,0 +1,88 @@
+#ifndef QWSTYLESHEET_H
+#define QWSTYLESHEET_H
+
+#include "QtWin/QWPaletteCache.h"
+
+#include <QColor>
+#include <QSharedPointer>
+#include <QString>
+
+namespace QtWin {
+
+/**
+ * @class QWStyleSheet
+ * @brief 带主题颜色占位符的 QSS 模板。
+ *
+ * 模板中的 @role.tone（如 @mainColor.40）在渲染时替换为该色彩角色与色调的颜色，
+ * 省略色调的 @role 使用当前模式的默认色调，@@ 表示字符 @。
+ * 模板在构造时解析一次为文本片段与占位符列表；渲染结果按
+ * 种子颜色 + 浅/深色调 + 深浅模式 缓存，复制的对象共享解析结果与缓存。
+ * prerender() 在后台线程中提前渲染尚未使用的模式，切换深浅色时直接取用。
+ *
+ * 渲染与缓存是线程安全的。
+ */
+class QWStyleSheet {
+public:
+    QWStyleSheet();
+    explicit QWStyleSheet(const QString& source);
+
+    /**
+     * @brief 是否为空模板（默认构造）。
+     */
+    bool isNull() const;
+
+    /**
+     * @brief 模板原文。
+     */
+    QString source() const;
+
+    /**
+     * @brief 模板中的占位符数量。无法识别的 @name 按原文保留，不计入。
+     */
+    int placeholderCount() const;
+
+    /**
+     * @brief 用色调表渲染模板，不经过缓存。
+     * @param tones 色调表
+     * @param defaultTone 省略色调的占位符使用的色调
+     */
+    QString render(const QWToneTable& tones, int defaultTone) const;
+
+    /**
+     * @brief 渲染指定主题状态下的样式表，命中缓存时直接返回。
+     * @param seed 种子颜色（忽略 alpha）
+     * @param lightTone 浅色模式色调
+     * @param darkTone 深色模式色调
+     * @param dark 是否为深色模式，决定省略色调的占位符使用哪个色调
+     */
+    QString render(const QColor& seed, int lightTone, int darkTone, bool dark) const;
+
+    /**
+     * @brief 在后台线程中渲染指定主题状态并放入缓存，已缓存或正在渲染时什么也不做。
+     */
+    void prerender(const QColor& seed, int lightTone, int darkTone, bool dark) const;
+
+    /**
+     * @brief 指定主题状态是否已经渲染好。
+     */
+    bool isCached(const QColor& seed, int lightTone, int darkTone, bool dark) const;
+
+    /**
+     * @brief 设置缓存的主题状态数量，默认 8，按最近最少使用淘汰。
+     */
+    void setCacheCapacity(int capacity);
+    int cacheCapacity() const;
+
+    /**
+     * @brief 清空渲染缓存，解析结果保留。
+     */
+    void clearCache();
+
+private:
+    struct Data;
+    QSharedPointer<Data> d;
+};
+
+} // namespace QtWin
+
+#endif
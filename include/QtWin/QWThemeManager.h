@@ -0,0 +1,130 @@
+#ifndef QWTHEMEMANAGER_H
+#define QWTHEMEMANAGER_H
+
+#include "QtWin/QWPaletteCache.h"
+
+#include <QCache>
+#include <QColor>
+#include <QObject>
+#include <QPalette>
+#include <QSet>
+#include <QThreadPool>
+
+#include <vector>
+
+namespace QtWin {
+
+/**
+ * @class QWThemeManager
+ * @brief 在窗口之间共享预先构建好的 QPalette。
+ *
+ * 由 QWApplication 持有，通过 QWApplication::themeManager() 访问。
+ * 对每个 种子颜色 + 浅/深色调 配置只构建一次浅色与深色两个不可变的 QPalette，
+ * 所有使用该配置的窗口共享同一份（隐式共享）数据。配置第一次被请求时两个模式一起构建
+ * （色调表已经就绪，另一个模式只是查表），切换深浅色时窗口只需换入现成的调色板。
+ * 即将使用的配置可以用 prewarm() 在后台线程中提前计算色调表。
+ *
+ * 只能在 GUI 线程中使用。
+ */
+class QWThemeManager : public QObject {
+    Q_OBJECT
+
+public:
+    explicit QWThemeManager(QObject* parent = nullptr);
+    ~QWThemeManager() override;
+
+    /**
+     * @brief 获取指定主题配置与模式的 QPalette，未命中时立即构建该配置的浅色与深色调色板。
+     * @param seed 种子颜色（忽略 alpha）
+     * @param lightTone 浅色模式色调
+     * @param darkTone 深色模式色调
+     * @param dark 是否为深色模式
+     * @param minimumContrast 文字角色与其背景的最低对比度（WCAG），0 表示不检查
+     */
+    QPalette palette(const QColor& seed, int lightTone, int darkTone, bool dark, double minimumContrast = 0.0);
+
+    /**
+     * @brief 指定主题配置与模式的 QPalette 是否已经构建好。
+     */
+    bool contains(const QColor& seed, int lightTone, int darkTone, bool dark, double minimumContrast = 0.0) const;
+
+    /**
+     * @brief 在后台线程中为即将使用的配置计算色调表（需要时还有亮度表），
+     * 完成后回到 GUI 线程组装浅色与深色 QPalette 并放入缓存。
+     * 已经缓存或正在预热时什么也不做。适合在用户悬停候选颜色、切换壁纸等即将更换种子时调用。
+     */
+    void prewarm(const QColor& seed, int lightTone, int darkTone, double minimumContrast = 0.0);
+
+    /**
+     * @brief 放入预先构建好的浅色与深色调色板（例如从主题快照恢复），已有的条目被替换。
+     * @param colors 该配置共享的调色板与色调表
+     */
+    void insert(const QColor& seed, int lightTone, int darkTone, double minimumContrast,
+                const QWPaletteCache::Entry& colors, const QPalette& light, const QPalette& dark);
+
+    /**
+     * @brief 设置缓存的主题配置数量，默认 16。
+     */
+    void setCapacity(int capacity);
+    int capacity() const;
+
+    /**
+     * @brief 清空缓存。已经分发给窗口的 QPalette 不受影响。
+     */
+    void clear();
+
+    /**
+     * @brief 由色调表构建 QPalette，不经过缓存。
+     * 窗口背景、输入控件、按钮、高亮与链接分别取 neutralAccent、neutralColor、
+     * subColor、accentColor 与 mainColor；文字使用相反模式的色调。
+     */
+    static QPalette createPalette(const QWToneTable& tones, int lightTone, int darkTone, bool dark);
+
+    /**
+     * @brief 同上，并保证文字角色（WindowText、Text、ButtonText、HighlightedText、
+     * Link、LinkVisited）与其背景的对比度不低于 minimumContrast。
+     * 相反模式的色调已经足够时保持不变，否则用 QWPalette::toneForContrast() 求出
+     * 最接近背景且满足对比度的色调。minimumContrast 为 0 时与上面的重载相同。
+     */
+    static QPalette createPalette(const QWPaletteCache::Entry& colors, int lightTone, int darkTone, bool dark,
+                                  double minimumContrast);
+
+    /**
+     * @brief 比较两个调色板，返回颜色不同的角色位掩码，第 n 位对应 QPalette::ColorRole n。
+     * 同时比较 Active、Inactive 与 Disabled 三个颜色组。
+     */
+    static quint32 changedRoles(const QPalette& from, const QPalette& to);
+
+    /**
+     * @brief 在 HCT 空间中插值，预先生成从 from 过渡到 to 的 steps 个调色板。
+     * 第 k 个（从 0 开始）对应进度 (k + 1) / steps，最后一个就是 to 本身。
+     * 只有颜色不同的角色参与插值；色相沿较短的方向变化。
+     */
+    static std::vector<QPalette> interpolate(const QPalette& from, const QPalette& to, int steps);
+
+private:
+    Q_DISABLE_COPY(QWThemeManager)
+
+    struct Key {
+        QWPaletteCache::Key colors;
+        int contrast; // 最低对比度 × 100，0 表示不检查
+
+        bool operator==(const Key& other) const;
+    };
+    friend size_t qHash(const Key& key, size_t seed) noexcept;
+
+    static Key makeKey(const QColor& seed, int lightTone, int darkTone, double minimumContrast);
+
+    struct Theme {
+        QWPaletteCache::Entry colors; // 共享的色调表
+        QPalette palettes[2];         // [0] 浅色，[1] 深色
+    };
+
+    QCache<Key, Theme> m_themes;
+    QSet<Key> m_warming; // 正在后台预热的配置
+    QThreadPool m_pool;  // 后台预热，单线程
+};
+
+} // namespace QtWin
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef QWTHEMESNAPSHOT_H
+#define QWTHEMESNAPSHOT_H
+
+#include "QtWin/QWPaletteCache.h"
+
+#include <QByteArray>
+#include <QColor>
+#include <QPalette>
+#include <QSharedPointer>
+#include <QString>
+
+namespace QtWin {
+
+class QWSettings;
+class QWThemeManager;
+
+/**
+ * @class QWThemeSnapshot
+ * @brief 完整计算好的主题状态：种子颜色、色调、色调表与浅色/深色两个 QPalette。
+ *
+ * 快照可以序列化到 QWSettings 或一个小的二进制文件。下次启动时 QWApplication
+ * 读取快照并放入 QWPaletteCache 与 QWThemeManager，新窗口在首次显示前直接使用，
+ * 不做任何颜色计算，也不会先用默认种子构建一次再切换到用户保存的种子。
+ *
+ * 反序列化时校验格式版本、库版本与校验和，任何一项不匹配时得到无效快照。
+ */
+class QWThemeSnapshot {
+public:
+    QWThemeSnapshot();
+
+    /**
+     * @brief 捕获指定主题配置的快照。色调表取自 QWPaletteCache；
+     * 提供 manager 时调色板取自它的缓存，否则直接构建。
+     */
+    static QWThemeSnapshot capture(const QColor& seed, int lightTone, int darkTone,
+                                   double minimumTextContrast = 0.0, QWThemeManager* manager = nullptr);
+
+    bool isValid() const;
+
+    QColor seedColor() const;
+    int lightTone() const;
+    int darkTone() const;
+    double minimumTextContrast() const;
+
+    /**
+     * @brief 快照保存的调色板与色调表，无效快照返回空条目。
+     */
+    QWPaletteCache::Entry colors() const;
+
+    /**
+     * @brief 快照保存的 QPalette。
+     */
+    QPalette palette(bool dark) const;
+
+    /**
+     * @brief 是否与指定的主题配置一致。
+     */
+    bool matches(const QColor& seed, int lightTone, int darkTone, double minimumTextContrast = 0.0) const;
+
+    /**
+     * @brief 把色调表与调色板放入 QWPaletteCache，提供 manager 时同时放入它的缓存。
+     * 之后相同配置的窗口直接命中缓存。
+     */
+    void restore(QWThemeManager* manager = nullptr) const;
+
+    /**
+     * @brief 序列化为二进制数据，无效快照返回空数据。
+     */
+    QByteArray toByteArray() const;
+
+    /**
+     * @brief 从二进制数据恢复。格式版本、库版本或校验和不匹配时返回无效快照。
+     */
+    static QWThemeSnapshot fromByteArray(const QByteArray& data);
+
+    /**
+     * @brief 保存到 QWSettings 的 key 下。
+     */
+    void save(QWSettings* settings, const QString& key = QStringLiteral("QtWin/themeSnapshot")) const;
+    static QWThemeSnapshot load(const QWSettings* settings, const QString& key = QStringLiteral("QtWin/themeSnapshot"));
+
+    /**
+     * @brief 保存到文件（原子替换）。
+     * @return 写入失败时返回 false
+     */
+    bool saveToFile(const QString& path) const;
+    static QWThemeSnapshot loadFromFile(const QString& path);
+
+private:
+    QColor m_seed;
+    HCTColor m_seedHct{0, 0, 0}; // 种子的 HCT，恢复 QWPalette 时不需要再转换
+    int m_lightTone = 80;
+    int m_darkTone = 20;
+    double m_minimumTextContrast = 0.0;
+    QSharedPointer<const QWToneTable> m_tones;
+    QPalette m_palettes[2]; // [0] 浅色，[1] 深色
+};
+
+} // namespace QtWin
+
+#endif
@@ -2,11 +2,21 @@
 #define QWWINDOW_H
 
 #include "QtWin/QWPalette.h"
+#include "QtWin/QWPaletteCache.h"
+#include "QtWin/QWStyleSheet.h"
+#include "QtWin/QWThemeSnapshot.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QPalette>
+#include <QPointer>
 #include <QWidget>
 
+#include <vector>
+
 QT_BEGIN_NAMESPACE
 class QVBoxLayout;
 class QShowEvent;
+class QTimer;
 QT_END_NAMESPACE
 
 namespace QtWin {
@@ -18,6 +28,8 @@ class QWWindow : public QWidget {
     Q_PROPERTY(int lightTone READ lightTone WRITE setLightTone NOTIFY toneChanged)
     Q_PROPERTY(int darkTone READ darkTone WRITE setDarkTone NOTIFY toneChanged)
     Q_PROPERTY(MaterialType material READ material WRITE setMaterial NOTIFY materialChanged)
+    Q_PROPERTY(int themeTransitionDuration READ themeTransitionDuration WRITE setThemeTransitionDuration)
+    Q_PROPERTY(double minimumTextContrast READ minimumTextContrast WRITE setMinimumTextContrast)
 
 public:
     enum MaterialType {
@@ -28,6 +40,44 @@ public:
     };
     Q_ENUM(MaterialType)
 
+    /**
+     * @brief 主题变化时调色板的传播范围
+     */
+    enum PaletteUpdateMode {
+        FullTree = 1,          // 设置在窗口上，传播到整个控件树（默认）
+        RegisteredSubtrees = 2 // 只更新注册的子树中发生变化的颜色角色，窗口背景由 paintEvent 绘制
+    };
+    Q_ENUM(PaletteUpdateMode)
+
+    /**
+     * @brief 批量修改主题的 RAII 守卫
+     *
+     * 守卫存在期间，setSeedColor / setLightTone / setDarkTone / setMaterial 等修改
+     * 只标记主题待更新，最外层守卫析构时立即统一应用一次。可以嵌套。
+     * 没有守卫时，同一轮事件循环中的多次修改也会合并为一次应用。
+     */
+    class ThemeBatch {
+    public:
+        explicit ThemeBatch(QWWindow *window);
+        ~ThemeBatch();
+
+    private:
+        Q_DISABLE_COPY(ThemeBatch)
+        QWWindow *m_window;
+    };
+
+    /**
+     * @brief 窗口自身 paintEvent 的统计数据（不包括子控件的绘制）
+     */
+    struct PaintStats {
+        quint64 paints = 0;      // 绘制次数
+        qint64 totalNsecs = 0;   // 累计耗时（纳秒）
+        qint64 maxNsecs = 0;     // 单次最长耗时（纳秒）
+        qint64 lastNsecs = 0;    // 最近一次耗时（纳秒）
+        quint64 totalArea = 0;   // 累计暴露面积（像素）
+        quint64 lastArea = 0;    // 最近一次暴露面积（像素）
+    };
+
     explicit QWWindow(QWidget *parent = nullptr);
     ~QWWindow() override;
 
@@ -65,6 +115,75 @@ public:
      */
     bool isDarkMode() const;
 
+    /**
+     * @brief 设置调色板的传播范围，默认 FullTree
+     *
+     * 无论哪种模式，主题更新都会先比较各颜色角色，没有角色变化时不调用 setPalette，
+     * 也就不会遍历控件树。控件很多时可以使用 RegisteredSubtrees，只有注册的子树
+     * 会收到变化的角色，其余控件保持原有调色板。应在添加子控件之前设置。
+     */
+    void setPaletteUpdateMode(PaletteUpdateMode mode);
+    PaletteUpdateMode paletteUpdateMode() const;
+
+    /**
+     * @brief 注册一个需要跟随主题的子树，立即应用当前主题
+     * 只在 RegisteredSubtrees 模式下使用；控件销毁时自动移除
+     */
+    void registerThemedWidget(QWidget *widget);
+    void unregisterThemedWidget(QWidget *widget);
+
+    /**
+     * @brief 设置主题切换的过渡动画时长（毫秒），0 表示立即切换（默认）
+     *
+     * 窗口可见时，深浅色、种子颜色或色调的变化会预先在 HCT 空间中插值出
+     * 每个刷新周期一帧的调色板，再由与屏幕刷新率对齐的精确定时器逐帧换入。
+     * 帧序号按实际经过的时间计算；某一帧的应用超出一半刷新周期的预算时，
+     * 之后的帧会相应跳过，而不是排队等待，过渡总时长保持不变。
+     */
+    void setThemeTransitionDuration(int msecs);
+    int themeTransitionDuration() const;
+
+    /**
+     * @brief 设置文字角色与其背景的最低对比度（WCAG 对比度，例如 4.5），0 表示不检查（默认）
+     *
+     * 默认情况下文字使用相反模式的色调。设置后，WindowText、Text、ButtonText、
+     * HighlightedText 与链接在对比度不足时改用 QWPalette::toneForContrast()
+     * 求出的、最接近背景且满足对比度的色调。
+     */
+    void setMinimumTextContrast(double ratio);
+    double minimumTextContrast() const;
+
+    /**
+     * @brief 设置跟随主题的样式表模板，空模板表示不使用样式表（默认）
+     *
+     * 每次应用主题时取出当前主题状态下渲染好的样式表，内容没有变化时不调用
+     * setStyleSheet；同时在后台预先渲染另一个模式，切换深浅色时无需重新格式化。
+     * 样式表不参与主题过渡动画，在过渡开始时一次切换。
+     */
+    void setThemeStyleSheet(const QWStyleSheet &sheet);
+    QWStyleSheet themeStyleSheet() const;
+
+    /**
+     * @brief 捕获窗口当前主题配置的快照
+     *
+     * 交给 QWApplication::setThemeSnapshot() 保存后，下次启动时新窗口在首次显示前
+     * 直接采用快照中的种子颜色、色调与最低对比度，不再计算颜色。
+     */
+    QWThemeSnapshot themeSnapshot() const;
+
+    /**
+     * @brief 获取窗口自 resetPaintStats() 以来的绘制统计
+     */
+    PaintStats paintStats() const;
+    void resetPaintStats();
+
+    /**
+     * @brief 每绘制 paints 次，通过 qtwin.core.window 日志类别（Debug 级别）输出一次
+     * 这一段的绘制次数、平均与最长耗时、平均暴露面积。0 表示不输出（默认）。
+     */
+    void setPaintStatsLogInterval(int paints);
+    int paintStatsLogInterval() const;
+
 public slots:
     void setSeedColor(const QColor &color);
     void setMaterial(MaterialType type);
@@ -85,20 +204,61 @@ private slots:
     void onThemeChanged(bool isDark);
 
 private:
+    // 修改时记录、应用主题后才发出的信号
+    enum PendingSignal {
+        SeedColorSignal = 0x1,
+        ToneSignal = 0x2,
+        MaterialSignal = 0x4,
+        ThemeSignal = 0x8
+    };
+
     void initialize();
     void updateCustomTheme();
+    void requestThemeUpdate();
+    void applyPendingTheme();
+    void emitPendingSignals();
     void updateFrame();
     void setupPalettes();
+    void applyThemePalette(const QPalette &themePalette);
+    void applyThemeRoles(QWidget *widget);
+    void startThemeTransition(const QPalette &target);
+    void advanceThemeTransition();
+    void refreshColorTheme();
+    void updatePaintAttributes();
+    void recordPaint(qint64 nsecs, quint64 area);
 
     QVBoxLayout *m_rootLayout;
     QWidget *m_centralWidget;
 
-    QWPalette m_palette;
+    QColor m_seedColor;
+    QWPaletteCache::Entry m_colorTheme; // 由 QWPaletteCache 共享的调色板与色调表
     int m_lightTone;
     int m_darkTone;
     bool m_isDarkMode;
     MaterialType m_material;
     bool m_firstShow;
+    bool m_themeDirty;        // 有尚未应用到 QPalette 的主题修改
+    bool m_themeUpdateQueued; // 已投递延迟应用，等待事件循环执行
+    int m_themeBatchDepth;    // 嵌套的 ThemeBatch 数量
+    int m_pendingSignals;     // PendingSignal 的组合
+    PaletteUpdateMode m_paletteUpdateMode;
+    QPalette m_themePalette;            // 最近一次应用的主题调色板
+    QList<QPointer<QWidget>> m_themedWidgets; // RegisteredSubtrees 模式下注册的子树
+    QWStyleSheet m_themeStyleSheet;     // 跟随主题的样式表模板
+    double m_minimumTextContrast;       // 0 表示不检查
+
+    // 主题过渡动画
+    int m_transitionDuration;                  // 毫秒，0 表示不使用动画
+    QTimer *m_transitionTimer;                 // 首次使用时创建
+    QElapsedTimer m_transitionClock;
+    std::vector<QPalette> m_transitionFrames;  // 预先插值的调色板，最后一帧为目标
+    int m_transitionFrame;                     // 已应用的帧序号
+    qint64 m_transitionNextFrame;              // 超出预算后，下一帧最早的时间（毫秒）
+
+    // 绘制统计
+    PaintStats m_paintStats;
+    PaintStats m_paintLogWindow; // 上次输出日志以来的统计
+    int m_paintLogInterval;      // 0 表示不输出日志
 };
 
 } // namespace QtWin
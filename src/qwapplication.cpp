@@ -1,36 +1,169 @@
 #include "QtWin/QWApplication.h"
+#include "QtWin/QWThemeManager.h"
 
+#include <QMetaEnum>
+#include <QPromise>
 #include <QStandardPaths>
 #include <QDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
 
 QWLOGNAME(qtwinDefaultLogger,"qtwin.core.app")
 
 namespace QtWin {
 
+/**
+ * 日志与设置系统的初始化：路径解析、创建目录、打开日志文件与解析配置文件都涉及磁盘 I/O。
+ * Concurrent 模式下在工作线程中执行，完成后由主线程接管设置对象；
+ * 工作线程只把自己创建的设置对象移到主线程，设置父对象等其余步骤都在 GUI 线程中完成。
+ */
+struct QWApplication::StartupServices {
+    QWSettings* settings = nullptr;
+    QList<StartupPhase> phases;
+
+    void run(const QElapsedTimer& clock, QThread* target, bool worker) {
+        qint64 start = clock.nsecsElapsed();
+        const auto phase = [&](const char* name) {
+            const qint64 now = clock.nsecsElapsed();
+            phases.append(StartupPhase{QString::fromLatin1(name), start, now - start, worker});
+            start = now;
+        };
+
+        // 日志文件将存储在标准的、平台特定的用户数据位置。
+        const QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataPath); // 确保目录存在。
+        phase("paths");
+
+        QWLogger::init(dataPath + "/app.log");
+        qwLogger(LogLevel::Info,qtwinDefaultLogger)<<"App name :"<<QApplication::applicationName()<<", App Version :"<<QApplication::applicationVersion();
+        phase("logger");
+
+        // 没有父对象：工作线程中创建的对象先移到主线程（只能由对象所在的线程推出），再由主线程设置父对象
+        settings = new QWSettings(nullptr);
+        if (worker) {
+            settings->moveToThread(target);
+        }
+        phase("settings");
+    }
+};
+
 QWApplication::QWApplication(int &argc, char **argv,
                             const QString &orgName,
                             const QString &appName,
                             const QString &appVersion,
-                            bool isDarkMode)
+                            bool isDarkMode,
+                            InitMode initMode)
         : QApplication(argc, argv),
         m_isDarkMode(isDarkMode),
-        m_settings(nullptr) {
+        m_settings(nullptr),
+        m_themeManager(nullptr),
+        m_initMode(initMode),
+        m_startupServices(std::make_shared<StartupServices>()),
+        m_firstWindowNsecs(-1),
+        m_startupReported(false) {
+    m_startupClock.start();
+    m_startupDone.start();
+    m_startupReady = m_startupDone.future();
+
     // 1. 首先设置应用信息，这对 QSettings 和 QStandardPaths 至关重要。
     QApplication::setOrganizationName(orgName);
     QApplication::setApplicationName(appName);
     QApplication::setApplicationVersion(appVersion);
 
-    // 2. 初始化日志系统。
-    // 日志文件将存储在标准的、平台特定的用户数据位置。
-    const QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(dataPath); // 确保目录存在。
-    const QString logFilePath = dataPath + "/app.log";
-    QWLogger::init(logFilePath);
-    qwLogger(LogLevel::Info,qtwinDefaultLogger)<<"App name :"<<instance()->applicationName()<<", App Version :"<<instance()->applicationVersion();
+    // 2. 初始化日志与设置系统。
+    // Concurrent 模式下交给工作线程，与主线程上的界面创建重叠进行。
+    if (m_initMode == Concurrent) {
+        auto promise = std::make_shared<QPromise<void>>();
+        m_startupTask = promise->future();
+        promise->start();
+        QThreadPool::globalInstance()->start([promise, services = m_startupServices,
+                                              clock = m_startupClock, target = thread()]() {
+            services->run(clock, target, true);
+            promise->finish();
+        });
+    }
+
+    // 3. 初始化主题管理器，所有 QWWindow 共享它构建的 QPalette
+    const qint64 start = m_startupClock.nsecsElapsed();
+    m_themeManager = new QWThemeManager(this);
+    recordPhase(QStringLiteral("themeManager"), start);
 
-    // 3. 初始化设置系统
-    // 将 this 作为父对象，确保 QSettings 的生命周期由 QApplication 管理
-    m_settings = new QWSettings(this);
+    // 4. 完成初始化并恢复主题快照。
+    // Concurrent / Deferred 模式下最迟在第一次事件循环中完成，首次访问设置时提前完成。
+    if (m_initMode == Sequential) {
+        completeStartup();
+    } else {
+        QTimer::singleShot(0, this, &QWApplication::completeStartup);
+    }
+}
+
+QWApplication::~QWApplication() {
+    // 工作线程可能仍在初始化：等它结束，再释放未被接管的设置对象
+    m_startupTask.waitForFinished();
+    if (m_startupServices) {
+        delete m_startupServices->settings;
+    }
+}
+
+void QWApplication::completeStartup() {
+    if (QThread::currentThread() != thread()) {
+        // 其他线程不接触对象树，等待 GUI 线程完成初始化（首次访问或第一次事件循环）
+        m_startupReady.waitForFinished();
+        return;
+    }
+    std::call_once(m_startupOnce, [this]() { finishStartup(); });
+}
+
+void QWApplication::finishStartup() {
+    const std::shared_ptr<StartupServices> services = std::move(m_startupServices);
+
+    if (m_initMode == Concurrent) {
+        const qint64 start = m_startupClock.nsecsElapsed();
+        m_startupTask.waitForFinished();
+        m_startupPhases += services->phases;
+        recordPhase(QStringLiteral("wait"), start);
+    } else {
+        services->run(m_startupClock, thread(), false);
+        m_startupPhases += services->phases;
+    }
+
+    // 将 this 作为父对象，确保设置系统的生命周期由 QApplication 管理
+    m_settings = services->settings;
+    m_settings->setParent(this);
+
+    // 恢复上次保存的主题快照，窗口首次显示时不需要再计算颜色
+    const qint64 start = m_startupClock.nsecsElapsed();
+    m_themeSnapshot = QWThemeSnapshot::load(m_settings);
+    if (m_themeSnapshot.isValid()) {
+        m_themeSnapshot.restore(m_themeManager);
+        qwLogger(LogLevel::Info,qtwinDefaultLogger)<<"Restored theme snapshot, seed :"<<m_themeSnapshot.seedColor().name();
+    }
+    recordPhase(QStringLiteral("themeSnapshot"), start);
+
+    m_startupDone.finish();
+    reportStartup();
+}
+
+void QWApplication::recordPhase(const QString &name, qint64 startNsecs, bool worker) {
+    m_startupPhases.append(StartupPhase{name, startNsecs, m_startupClock.nsecsElapsed() - startNsecs, worker});
+}
+
+void QWApplication::reportStartup() {
+    // 初始化完成且首个窗口已经显示时输出一次
+    if (m_startupReported || m_startupServices || m_firstWindowNsecs < 0) {
+        return;
+    }
+    m_startupReported = true;
+
+    QStringList phases;
+    for (const StartupPhase& phase : std::as_const(m_startupPhases)) {
+        phases << QStringLiteral("%1 %2 ms%3").arg(phase.name)
+                                              .arg(phase.nsecs / 1e6, 0, 'f', 2)
+                                              .arg(phase.worker ? QStringLiteral(" [worker]") : QString());
+    }
+    qwLogger(LogLevel::Info,qtwinDefaultLogger)<<"Startup ("<<QMetaEnum::fromType<InitMode>().valueToKey(m_initMode)
+                                              <<") :"<<phases.join(", ");
 }
 
 QWApplication* QWApplication::instance() {
@@ -40,13 +173,49 @@ QWApplication* QWApplication::instance() {
 }
 
 QWSettings* QWApplication::settings() const {
+    // 尚未初始化完成时在这里等待（Concurrent）或立即完成（Deferred）；其他线程等待 GUI 线程完成
+    const_cast<QWApplication*>(this)->completeStartup();
     return m_settings;
 }
 
+QWThemeManager* QWApplication::themeManager() const {
+    return m_themeManager;
+}
+
+const QWThemeSnapshot& QWApplication::themeSnapshot() const {
+    // Deferred 模式下 GUI 线程不为快照提前初始化，首个窗口使用默认主题
+    if (m_initMode != Deferred || QThread::currentThread() != thread()) {
+        const_cast<QWApplication*>(this)->completeStartup();
+    }
+    return m_themeSnapshot;
+}
+
+void QWApplication::setThemeSnapshot(const QWThemeSnapshot& snapshot) {
+    m_themeSnapshot = snapshot;
+    m_themeSnapshot.save(settings());
+}
+
 bool QWApplication::isDarkMode() const {
     return m_isDarkMode;
 }
 
+QWApplication::InitMode QWApplication::initMode() const {
+    return m_initMode;
+}
+
+QList<QWApplication::StartupPhase> QWApplication::startupPhases() const {
+    return m_startupPhases;
+}
+
+void QWApplication::markFirstWindowShown() {
+    if (m_firstWindowNsecs >= 0) {
+        return;
+    }
+    m_firstWindowNsecs = m_startupClock.nsecsElapsed();
+    m_startupPhases.append(StartupPhase{QStringLiteral("firstWindow"), 0, m_firstWindowNsecs, false});
+    reportStartup();
+}
+
 void QWApplication::setDarkMode(bool dark) {
     if (m_isDarkMode!= dark) {
         m_isDarkMode = dark;
@@ -0,0 +1,413 @@
+#ifndef QWCOLORMATH_P_H
+#define QWCOLORMATH_P_H
+
+// 内部头文件，不安装，不属于公共 API。
+//
+// HCT <-> sRGB 转换内核，按标量类型模板化：
+//   double  参考实现，结果与历史版本逐位一致
+//   float   单精度，向量宽度加倍
+//   Fixed   Q16.16 定点整数，不使用任何浮点超越函数
+// 各精度的 8 位输出误差上限见 QWPalette.h 中 ColorPrecision 的说明，
+// 并由 tests/tst_qwpalette.cpp 穷举验证。
+
+#include "QtWin/QWPalette.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace QtWin {
+namespace ColorMath {
+
+// ---------------------------------------------------------------------------
+// 常量
+// ---------------------------------------------------------------------------
+
+// Helper constants for D65 white point and sRGB<->XYZ matrices
+constexpr double D65_X = 95.047, D65_Y = 100.000, D65_Z = 108.883;
+
+// sRGB to XYZ (D65), linear transform coefficients
+constexpr double SRGB_TO_XYZ[3][3] = {
+    {0.4124, 0.3576, 0.1805},
+    {0.2126, 0.7152, 0.0722},
+    {0.0193, 0.1192, 0.9505}
+};
+// XYZ to sRGB, inverse of above
+constexpr double XYZ_TO_SRGB[3][3] = {
+    { 3.2406, -1.5372, -0.4986},
+    {-0.9689,  1.8758,  0.0415},
+    { 0.0557, -0.2040,  1.0570}
+};
+
+/** 线性化 sRGB 分量（逆伽马）。 */
+inline double linearize(double c) {
+    if (c <= 0.04045) return c / 12.92;
+    return std::pow((c + 0.055) / 1.055, 2.4);
+}
+/** 反线性化 sRGB 分量（伽马校正）。 */
+inline double delinearize(double c) {
+    if (c <= 0.0031308) return c * 12.92;
+    return 1.055 * std::pow(c, 1.0/2.4) - 0.055;
+}
+
+/** 8 位 sRGB 分量的线性化查找表，与 linearize(i / 255.0) 逐项相同。 */
+const double* linearizeTable();
+
+/** 最大彩度表的插值估计（hue 已规整到 [0,360)，tone 在 [0,100]），定义在 qwpalette.cpp。 */
+double maxChromaEstimate(double hue, double tone);
+
+// ---------------------------------------------------------------------------
+// Q16.16 定点数
+// ---------------------------------------------------------------------------
+
+struct Fixed {
+    static constexpr int kFracBits = 16;
+    static constexpr std::int32_t kOne = 1 << kFracBits;
+
+    std::int32_t raw;
+
+    static constexpr Fixed fromRaw(std::int32_t r) { return Fixed{r}; }
+    static constexpr Fixed fromDouble(double v) {
+        return Fixed{static_cast<std::int32_t>(v * kOne + (v >= 0 ? 0.5 : -0.5))};
+    }
+    constexpr double toDouble() const { return static_cast<double>(raw) / kOne; }
+};
+
+constexpr Fixed operator+(Fixed a, Fixed b) { return Fixed{a.raw + b.raw}; }
+constexpr Fixed operator-(Fixed a, Fixed b) { return Fixed{a.raw - b.raw}; }
+constexpr Fixed operator-(Fixed a) { return Fixed{-a.raw}; }
+constexpr Fixed operator*(Fixed a, Fixed b) {
+    // 64 位中间结果，四舍五入
+    return Fixed{static_cast<std::int32_t>((static_cast<std::int64_t>(a.raw) * b.raw + (Fixed::kOne >> 1)) >> Fixed::kFracBits)};
+}
+constexpr Fixed operator/(Fixed a, Fixed b) {
+    return Fixed{static_cast<std::int32_t>((static_cast<std::int64_t>(a.raw) << Fixed::kFracBits) / b.raw)};
+}
+constexpr bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+constexpr bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+/** 定点数使用的查找表，首次使用时构建。 */
+struct FixedTables {
+    static constexpr int kCbrtBits = 10;                 // 每单位 1024 格
+    static constexpr int kCbrtSize = (2 << kCbrtBits) + 1; // 覆盖 [0,2]
+    static constexpr int kDelinBits = 12;                // [0,1] 分为 4096 格
+    static constexpr int kDelinSize = (1 << kDelinBits) + 1;
+    static constexpr int kSinSteps = 8;                  // 每度 8 格
+    static constexpr int kSinSize = 90 * kSinSteps + 1;  // 四分之一周期
+    static constexpr int kSqrtSeedBits = 11;             // sqrt 初值表的小数位数
+
+    std::int32_t linear[256];     // Q16 线性值
+    std::int32_t cbrt[kCbrtSize]; // Q16
+    std::int32_t delin[kDelinSize]; // sRGB * 255，Q8
+    std::int32_t sinQ[kSinSize];  // Q16
+    std::uint16_t sqrtSeed[1024]; // sqrt(i)，kSqrtSeedBits 位小数
+
+    FixedTables();
+    static const FixedTables& instance();
+};
+
+// ---------------------------------------------------------------------------
+// 标量特性：每种标量类型提供的基本运算
+// ---------------------------------------------------------------------------
+
+template<typename T> struct ScalarTraits;
+
+template<> struct ScalarTraits<double> {
+    static double from(double v) { return v; }
+    static double toDouble(double v) { return v; }
+    static double linearize8(int c) { return linearizeTable()[c]; }
+    static int delinearize8(double c) {
+        return static_cast<int>(std::lround(std::clamp(delinearize(c), 0.0, 1.0) * 255.0));
+    }
+    static double cbrt(double v) { return std::cbrt(v); }
+    static double hueDegrees(double b, double a) {
+        double hue = std::atan2(b, a) * 180.0 / M_PI;  // atan2 返回弧度
+        if (hue < 0) hue += 360.0;
+        return hue;
+    }
+    static double hypot(double a, double b) { return std::sqrt(a*a + b*b); }
+    static void cosSinDegrees(double hue, double& c, double& s) {
+        c = std::cos(hue * M_PI/180.0);
+        s = std::sin(hue * M_PI/180.0);
+    }
+};
+
+template<> struct ScalarTraits<float> {
+    static float from(double v) { return static_cast<float>(v); }
+    static double toDouble(float v) { return v; }
+    static float linearize8(int c) { return static_cast<float>(linearizeTable()[c]); }
+    static int delinearize8(float c) {
+        float v = (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1.0f/2.4f) - 0.055f;
+        return static_cast<int>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+    }
+    static float cbrt(float v) { return std::cbrt(v); }
+    static float hueDegrees(float b, float a) {
+        float hue = std::atan2(b, a) * (180.0f / static_cast<float>(M_PI));
+        if (hue < 0) hue += 360.0f;
+        return hue;
+    }
+    static float hypot(float a, float b) { return std::sqrt(a*a + b*b); }
+    static void cosSinDegrees(double hue, float& c, float& s) {
+        const float rad = static_cast<float>(hue) * (static_cast<float>(M_PI) / 180.0f);
+        c = std::cos(rad);
+        s = std::sin(rad);
+    }
+};
+
+template<> struct ScalarTraits<Fixed> {
+    static constexpr Fixed from(double v) { return Fixed::fromDouble(v); }
+    static double toDouble(Fixed v) { return v.toDouble(); }
+
+    static Fixed linearize8(int c) { return Fixed{FixedTables::instance().linear[c]}; }
+
+    static int delinearize8(Fixed c) {
+        // 线性插值查表，表中存放 sRGB * 255 的 Q8 值
+        const std::int32_t v = std::clamp(c.raw, 0, Fixed::kOne);
+        constexpr int shift = Fixed::kFracBits - FixedTables::kDelinBits;
+        const int index = v >> shift;
+        const int frac = v & ((1 << shift) - 1);
+        const std::int32_t* lut = FixedTables::instance().delin;
+        std::int32_t out = lut[index];
+        if (frac) out += ((lut[index + 1] - out) * frac) >> shift;
+        return (out + 128) >> 8;
+    }
+
+    static Fixed cbrt(Fixed t) {
+        // 仅用于 t > (6/29)^3 的分支，输入为 XYZ / 白点，落在 [0,2] 内
+        const std::int32_t v = std::clamp(t.raw, 0, 2 * Fixed::kOne);
+        constexpr int shift = Fixed::kFracBits - FixedTables::kCbrtBits;
+        const int index = std::min(v >> shift, FixedTables::kCbrtSize - 2);
+        const std::int32_t frac = v - (index << shift);
+        const std::int32_t* lut = FixedTables::instance().cbrt;
+        return Fixed{lut[index] + static_cast<std::int32_t>(
+            (static_cast<std::int64_t>(lut[index + 1] - lut[index]) * frac) >> shift)};
+    }
+
+    static Fixed hueDegrees(Fixed b, Fixed a) {
+        // 八分圆约化 + 多项式 atan，误差约 1e-5 弧度
+        const std::int32_t ax = a.raw < 0 ? -a.raw : a.raw;
+        const std::int32_t ay = b.raw < 0 ? -b.raw : b.raw;
+        if (ax == 0 && ay == 0) return Fixed{0};
+        const bool swap = ay > ax;
+        const Fixed z = swap ? Fixed{ax} / Fixed{ay} : Fixed{ay} / Fixed{ax};
+        const Fixed z2 = z * z;
+        Fixed p = from(0.0208351);
+        p = p * z2 + from(-0.0851330);
+        p = p * z2 + from(0.1801410);
+        p = p * z2 + from(-0.3302995);
+        p = p * z2 + from(0.9998660);
+        Fixed angle = p * z; // [0, pi/4]
+        if (swap) angle = from(M_PI / 2) - angle;
+        if (a.raw < 0) angle = from(M_PI) - angle;
+        if (b.raw < 0) angle = -angle;
+        Fixed hue = angle * from(180.0 / M_PI);
+        if (hue.raw < 0) hue = hue + from(360.0);
+        return hue;
+    }
+
+    static Fixed hypot(Fixed a, Fixed b) {
+        // Q32 平方和开方即为 Q16 结果：查表得到初值，再做一次牛顿迭代
+        const std::uint64_t n = static_cast<std::uint64_t>(static_cast<std::int64_t>(a.raw) * a.raw)
+                            + static_cast<std::uint64_t>(static_cast<std::int64_t>(b.raw) * b.raw);
+        if (n == 0) return Fixed{0};
+        // 取偶数位移 s 使 n >> s 落在 [256, 1024)
+        const int bits = 64 - countLeadingZeros(n);
+        const int s = bits > 10 ? ((bits - 9) & ~1) : 0;
+        const int half = s / 2;
+        const std::uint64_t seed = FixedTables::instance().sqrtSeed[n >> s];
+        std::uint64_t x = half >= FixedTables::kSqrtSeedBits
+                        ? seed << (half - FixedTables::kSqrtSeedBits)
+                        : seed >> (FixedTables::kSqrtSeedBits - half);
+        if (x == 0) x = 1;
+        x = (x + n / x) >> 1;
+        // 修正到 floor(sqrt(n))，再四舍五入
+        while (x * x > n) --x;
+        while ((x + 1) * (x + 1) <= n) ++x;
+        if (n - x * x > x) ++x;
+        return Fixed{static_cast<std::int32_t>(x)};
+    }
+
+    static int countLeadingZeros(std::uint64_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return 63 - static_cast<int>(index);
+#else
+        return __builtin_clzll(v);
+#endif
+    }
+
+    static void cosSinDegrees(double hue, Fixed& c, Fixed& s) {
+        // 色相以 1/8 度为单位定点化，四分之一周期查表 + 线性插值
+        constexpr int kFullTurn = 360 * FixedTables::kSinSteps;
+        constexpr int kQuarter = 90 * FixedTables::kSinSteps;
+        std::int32_t h = static_cast<std::int32_t>(hue * FixedTables::kSinSteps * 256.0 + 0.5);
+        h %= kFullTurn * 256;
+        if (h < 0) h += kFullTurn * 256;
+        const auto sinAt = [](std::int32_t x) {
+            // x: 以 1/2048 度为单位，[0, 360)
+            const std::int32_t* lut = FixedTables::instance().sinQ;
+            const int quadrant = x / (kQuarter * 256);
+            std::int32_t r = x - quadrant * kQuarter * 256;
+            if (quadrant & 1) r = kQuarter * 256 - r;
+            const int index = r >> 8;
+            const int frac = r & 255;
+            std::int32_t v = lut[index];
+            if (frac) v += ((lut[index + 1] - v) * frac) >> 8;
+            return (quadrant & 2) ? -v : v;
+        };
+        s = Fixed{sinAt(h)};
+        c = Fixed{sinAt((h + kQuarter * 256) % (kFullTurn * 256))};
+    }
+};
+
+// ---------------------------------------------------------------------------
+// 转换内核
+// ---------------------------------------------------------------------------
+
+/** XYZ -> Lab 辅助函数 f(t)。 */
+template<typename T>
+T pivotLab(T t) {
+    using S = ScalarTraits<T>;
+    const double delta = 6.0/29.0;
+    if (t > S::from(delta*delta*delta)) return S::cbrt(t);
+    return t / S::from(3*delta*delta) + S::from(4.0/29.0);
+}
+
+/** 从 8 位 sRGB 计算 HCTColor。 */
+template<typename T>
+HCTColor rgbToHct(const RGBColor& rgb) {
+    using S = ScalarTraits<T>;
+    // 1. 归一化并线性化 RGB（查表）
+    const T r = S::linearize8(std::clamp(rgb.red, 0, 255));
+    const T g = S::linearize8(std::clamp(rgb.green, 0, 255));
+    const T b = S::linearize8(std::clamp(rgb.blue, 0, 255));
+
+    // 2. 线性 RGB -> XYZ (D65)
+    //    计算 X, Y, Z，在转换矩阵作用后乘以100以匹配 Lab 公式
+    const T X = (S::from(SRGB_TO_XYZ[0][0])*r + S::from(SRGB_TO_XYZ[0][1])*g + S::from(SRGB_TO_XYZ[0][2])*b) * S::from(100.0);
+    const T Y = (S::from(SRGB_TO_XYZ[1][0])*r + S::from(SRGB_TO_XYZ[1][1])*g + S::from(SRGB_TO_XYZ[1][2])*b) * S::from(100.0);
+    const T Z = (S::from(SRGB_TO_XYZ[2][0])*r + S::from(SRGB_TO_XYZ[2][1])*g + S::from(SRGB_TO_XYZ[2][2])*b) * S::from(100.0);
+
+    // 3. XYZ -> Lab
+    const T fx = pivotLab(X / S::from(D65_X));
+    const T fy = pivotLab(Y / S::from(D65_Y));
+    const T fz = pivotLab(Z / S::from(D65_Z));
+    const T L = S::from(116.0) * fy - S::from(16.0);
+    const T a = S::from(500.0) * (fx - fy);
+    const T b_val = S::from(200.0) * (fy - fz);
+
+    // 4. 将 L* 作为 Tone，从 a*, b* 计算 Hue 和 Chroma（CIELCh 角度和值）
+    return { S::toDouble(S::hueDegrees(b_val, a)), S::toDouble(S::hypot(a, b_val)), S::toDouble(L) };
+}
+
+/** Lab -> 线性 sRGB（未裁剪，可能超出 [0,1]）。 */
+template<typename T>
+void labToLinearRGB(T L, T a, T b_val, T rgb[3]) {
+    using S = ScalarTraits<T>;
+    // Lab -> XYZ
+    const T fy = (L + S::from(16.0)) / S::from(116.0);
+    const T fx = fy + (a / S::from(500.0));
+    const T fz = fy - (b_val / S::from(200.0));
+    const T fx3 = fx*fx*fx;
+    const T fz3 = fz*fz*fz;
+    const T fy3 = fy*fy*fy;
+    const T eps = S::from(216.0/24389.0); // = (6/29)^3
+    const T kappa = S::from(24389.0/27.0); // = (29/3)^3
+
+    const T xr = (fx3 > eps) ? fx3 : (S::from(116.0)*fx - S::from(16.0)) / kappa;
+    const T yr = (L > (kappa * eps)) ? fy3 : L / kappa;
+    const T zr = (fz3 > eps) ? fz3 : (S::from(116.0)*fz - S::from(16.0)) / kappa;
+    const T X = xr * S::from(D65_X);
+    const T Y = yr * S::from(D65_Y);
+    const T Z = zr * S::from(D65_Z);
+
+    // XYZ -> 线性 RGB
+    for (int i = 0; i < 3; ++i) {
+        rgb[i] = (S::from(XYZ_TO_SRGB[i][0])*X + S::from(XYZ_TO_SRGB[i][1])*Y + S::from(XYZ_TO_SRGB[i][2])*Z) / S::from(100.0);
+    }
+}
+
+/** 线性 RGB 是否落在 sRGB 色域内（容差远小于 8 位量化步长）。 */
+template<typename T>
+bool isInGamut(const T rgb[3]) {
+    using S = ScalarTraits<T>;
+    const T low = S::from(-1e-6);
+    const T high = S::from(1.0 + 1e-6);
+    for (int i = 0; i < 3; ++i) {
+        if (rgb[i] < low || rgb[i] > high) return false;
+    }
+    return true;
+}
+
+/** 指定色相/色调/彩度的点是否在色域内。cosH、sinH 由调用方预先计算。 */
+template<typename T>
+bool isInGamut(T tone, T chroma, T cosH, T sinH) {
+    T rgb[3];
+    labToLinearRGB(tone, chroma * cosH, chroma * sinH, rgb);
+    return isInGamut(rgb);
+}
+
+/** 把色相规整到 [0,360)，色调限定到 [0,100]。 */
+inline void normalizeHueTone(double& hue, double& tone) {
+    if (hue < 0) hue = std::fmod(hue, 360.0) + 360.0;
+    if (hue >= 360) hue = std::fmod(hue, 360.0);
+    if (tone < 0) tone = 0;
+    if (tone > 100) tone = 100;
+}
+
+/** 从 HCTColor 生成 8 位 sRGB。 */
+template<typename T>
+RGBColor hctToRgb(const HCTColor& hct, GamutMapping mapping) {
+    using S = ScalarTraits<T>;
+    double hue = hct.hue;
+    double tone = hct.tone;
+    double chroma = hct.chroma;
+
+    // 限定 hue 在 [0,360)，tone 在 [0,100]
+    normalizeHueTone(hue, tone);
+
+    // 构造 Lab 空间中对应的色度和色相
+    //    L* = tone, a* = C * cos(hue), b* = C * sin(hue)
+    T cosH, sinH;
+    S::cosSinDegrees(hue, cosH, sinH);
+    const T L = S::from(tone);
+    T C = S::from(chroma);
+
+    T rgb[3];
+    labToLinearRGB(L, C * cosH, C * sinH, rgb);
+
+    if (mapping == GamutMapping::ReduceChroma && !isInGamut(rgb)) {
+        // 查表得到边界估计，再在估计值附近做几步二分细化，
+        // 而不是每次都从 [0, chroma] 开始完整二分。
+        double hi = std::min(chroma, maxChromaEstimate(hue, tone));
+        if (isInGamut(L, S::from(hi), cosH, sinH)) {
+            chroma = hi;
+        } else {
+            double lo = hi * 0.9;
+            if (!isInGamut(L, S::from(lo), cosH, sinH)) lo = 0.0;
+            for (int i = 0; i < 6; ++i) {
+                const double mid = (lo + hi) * 0.5;
+                if (isInGamut(L, S::from(mid), cosH, sinH)) lo = mid;
+                else hi = mid;
+            }
+            chroma = lo;
+        }
+        C = S::from(chroma);
+        labToLinearRGB(L, C * cosH, C * sinH, rgb);
+    }
+
+    // 反线性化并量化到 [0,255]
+    return { S::delinearize8(rgb[0]), S::delinearize8(rgb[1]), S::delinearize8(rgb[2]) };
+}
+
+} // namespace ColorMath
+} // namespace QtWin
+
+#endif
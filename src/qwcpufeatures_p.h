@@ -0,0 +1,65 @@
+#ifndef QWCPUFEATURES_P_H
+#define QWCPUFEATURES_P_H
+
+// 内部头文件：SIMD 内核的指令集检测，不属于公开 API。
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define QTWIN_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 需要按函数开启指令集；MSVC 无需标记即可使用这些内建函数
+#if defined(__GNUC__) || defined(__clang__)
+#define QTWIN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define QTWIN_TARGET(isa)
+#endif
+
+namespace QtWin {
+namespace Cpu {
+
+struct Features {
+    bool sse41 = false;
+    bool avx2 = false;
+};
+
+/**
+ * 检测一次并缓存。AVX2 同时要求操作系统保存 YMM 寄存器（OSXSAVE 且 XCR0 开启 SSE/AVX 状态）。
+ */
+inline const Features& features() {
+    static const Features detected = []() {
+        Features f;
+#ifdef QTWIN_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        f.sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+        if (maxLeaf >= 7 && osAvx) {
+            __cpuidex(info, 7, 0);
+            f.avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        // __builtin_cpu_supports("avx2") 已经包含操作系统支持的检查
+        __builtin_cpu_init();
+        f.sse41 = __builtin_cpu_supports("sse4.1");
+        f.avx2 = __builtin_cpu_supports("avx2");
+#endif
+#endif
+        return f;
+    }();
+    return detected;
+}
+
+inline bool hasSse41() { return features().sse41; }
+inline bool hasAvx2() { return features().avx2; }
+
+} // namespace Cpu
+} // namespace QtWin
+
+#endif
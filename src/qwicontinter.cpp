@@ -0,0 +1,235 @@
+#include "QtWin/QWIconTinter.h"
+#include "QtWin/QWWindow.h"
+#include "qwcpufeatures_p.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace QtWin {
+
+namespace {
+
+/*
+ * 着色内核：out = color × alpha / 255，color 已经预乘，四个通道同时缩放。
+ * 除以 255 使用 (t + (t >> 8)) >> 8（t = x + 128），对 0 ~ 255×255 的乘积精确舍入，
+ * 标量与 SIMD 版本逐位一致。
+ */
+enum class MaskLayout {
+    Alpha8, // 每像素一个字节
+    Argb32  // ARGB32 / ARGB32_Premultiplied，alpha 在最高字节
+};
+
+using TintRow = void (*)(const uchar* mask, QRgb* out, int count, QRgb color);
+
+inline std::uint32_t div255(std::uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+template<MaskLayout L>
+inline std::uint32_t maskAlpha(const uchar* mask, int x) {
+    if constexpr (L == MaskLayout::Alpha8) {
+        return mask[x];
+    } else {
+        return reinterpret_cast<const QRgb*>(mask)[x] >> 24;
+    }
+}
+
+template<MaskLayout L>
+void tintScalar(const uchar* mask, QRgb* out, int count, QRgb color) {
+    for (int x = 0; x < count; ++x) {
+        const std::uint32_t a = maskAlpha<L>(mask, x);
+        out[x] = (div255(qAlpha(color) * a) << 24) | (div255(qRed(color) * a) << 16)
+               | (div255(qGreen(color) * a) << 8) | div255(qBlue(color) * a);
+    }
+}
+
+#ifdef QTWIN_X86
+
+// 16 位元素中的 div255，乘积不超过 65025，加上舍入量仍不会溢出
+QTWIN_TARGET("sse4.1")
+inline __m128i div255x8(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/** alpha：每个 32 位元素是一个像素的 alpha；color：两份展开为 16 位的 BGRA。 */
+QTWIN_TARGET("sse4.1")
+inline __m128i tint4(__m128i alpha, __m128i color) {
+    const __m128i a = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+    const __m128i lo = div255x8(_mm_mullo_epi16(_mm_unpacklo_epi32(a, a), color));
+    const __m128i hi = div255x8(_mm_mullo_epi16(_mm_unpackhi_epi32(a, a), color));
+    return _mm_packus_epi16(lo, hi);
+}
+
+template<MaskLayout L>
+QTWIN_TARGET("sse4.1")
+void tintSse41(const uchar* mask, QRgb* out, int count, QRgb color) {
+    const __m128i color16 = _mm_cvtepu8_epi16(_mm_set1_epi32(static_cast<int>(color)));
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i alpha;
+        if constexpr (L == MaskLayout::Alpha8) {
+            std::int32_t bytes;
+            std::memcpy(&bytes, mask + x, sizeof(bytes));
+            alpha = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+        } else {
+            alpha = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + 4 * x)), 24);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), tint4(alpha, color16));
+    }
+    tintScalar<L>(L == MaskLayout::Alpha8 ? mask + x : mask + 4 * x, out + x, count - x, color);
+}
+
+QTWIN_TARGET("avx2")
+inline __m256i div255x16(__m256i x) {
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// 解包与打包都在各自的 128 位通道内进行，像素顺序保持不变
+QTWIN_TARGET("avx2")
+inline __m256i tint8(__m256i alpha, __m256i color) {
+    const __m256i a = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+    const __m256i lo = div255x16(_mm256_mullo_epi16(_mm256_unpacklo_epi32(a, a), color));
+    const __m256i hi = div255x16(_mm256_mullo_epi16(_mm256_unpackhi_epi32(a, a), color));
+    return _mm256_packus_epi16(lo, hi);
+}
+
+template<MaskLayout L>
+QTWIN_TARGET("avx2")
+void tintAvx2(const uchar* mask, QRgb* out, int count, QRgb color) {
+    const __m256i color16 = _mm256_cvtepu8_epi16(_mm_set1_epi32(static_cast<int>(color)));
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i alpha;
+        if constexpr (L == MaskLayout::Alpha8) {
+            alpha = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask + x)));
+        } else {
+            alpha = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + 4 * x)), 24);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), tint8(alpha, color16));
+    }
+    tintScalar<L>(L == MaskLayout::Alpha8 ? mask + x : mask + 4 * x, out + x, count - x, color);
+}
+
+#endif // QTWIN_X86
+
+struct TintKernels {
+    TintRow alpha8;
+    TintRow argb32;
+};
+
+TintKernels selectKernels() {
+#ifdef QTWIN_X86
+    if (Cpu::hasAvx2()) return {tintAvx2<MaskLayout::Alpha8>, tintAvx2<MaskLayout::Argb32>};
+    if (Cpu::hasSse41()) return {tintSse41<MaskLayout::Alpha8>, tintSse41<MaskLayout::Argb32>};
+#endif
+    return {tintScalar<MaskLayout::Alpha8>, tintScalar<MaskLayout::Argb32>};
+}
+
+int pixmapCost(const QPixmap& pixmap) {
+    // 以 KB 计，至少为 1，小图标也占用一个名额
+    return std::max(1, pixmap.width() * pixmap.height() * 4 / 1024);
+}
+
+} // namespace
+
+bool QWIconTinter::Key::operator==(const Key& other) const {
+    return id == other.id
+        && role == other.role
+        && tone == other.tone
+        && devicePixelRatio == other.devicePixelRatio;
+}
+
+size_t qHash(const QWIconTinter::Key& key, size_t seed) noexcept {
+    return qHashMulti(seed, key.id, key.role, key.tone, key.devicePixelRatio);
+}
+
+QWIconTinter::QWIconTinter(QWWindow* window)
+    : QObject(window),
+      m_window(window)
+{
+    m_cache.setMaxCost(8192);
+    // 缓存键中的色调已经确定，但颜色还取决于种子；任何主题变化都让全部结果失效
+    connect(window, &QWWindow::themeChanged, this, &QWIconTinter::clear);
+    connect(window, &QWWindow::seedColorChanged, this, &QWIconTinter::clear);
+    connect(window, &QWWindow::toneChanged, this, &QWIconTinter::clear);
+}
+
+QWIconTinter::~QWIconTinter() = default;
+
+QPixmap QWIconTinter::pixmap(const QString& id, const QImage& mask, QWPalette::QWColor role, int tone) {
+    const Key key{id, role, resolveTone(tone), mask.devicePixelRatio()};
+    if (const QPixmap* cached = m_cache.object(key)) {
+        return *cached;
+    }
+    return store(key, mask);
+}
+
+QPixmap QWIconTinter::pixmap(const QString& id, const QPixmap& mask, QWPalette::QWColor role, int tone) {
+    const Key key{id, role, resolveTone(tone), mask.devicePixelRatio()};
+    if (const QPixmap* cached = m_cache.object(key)) {
+        return *cached;
+    }
+    // 只有未命中时才把 QPixmap 读回内存
+    return store(key, mask.toImage());
+}
+
+void QWIconTinter::setCacheLimit(int kilobytes) {
+    m_cache.setMaxCost(std::max(1, kilobytes));
+}
+
+int QWIconTinter::cacheLimit() const {
+    return static_cast<int>(m_cache.maxCost());
+}
+
+int QWIconTinter::size() const {
+    return static_cast<int>(m_cache.count());
+}
+
+void QWIconTinter::clear() {
+    m_cache.clear();
+}
+
+QImage QWIconTinter::tinted(const QImage& mask, const QColor& color) {
+    if (mask.isNull()) {
+        return QImage();
+    }
+
+    QImage source = mask;
+    switch (source.format()) {
+        case QImage::Format_Alpha8:
+        case QImage::Format_ARGB32:
+        case QImage::Format_ARGB32_Premultiplied:
+            break;
+        default:
+            source = source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            break;
+    }
+
+    static const TintKernels kernels = selectKernels();
+    const TintRow row = source.format() == QImage::Format_Alpha8 ? kernels.alpha8 : kernels.argb32;
+    const QRgb premultiplied = qPremultiply(color.rgba());
+
+    QImage result(source.size(), QImage::Format_ARGB32_Premultiplied);
+    result.setDevicePixelRatio(mask.devicePixelRatio());
+    for (int y = 0; y < source.height(); ++y) {
+        row(source.constScanLine(y), reinterpret_cast<QRgb*>(result.scanLine(y)), source.width(), premultiplied);
+    }
+    return result;
+}
+
+int QWIconTinter::resolveTone(int tone) const {
+    return tone < 0 ? m_window->currentTone() : tone;
+}
+
+QPixmap QWIconTinter::store(const Key& key, const QImage& mask) {
+    const QColor color = m_window->getThemeColor(static_cast<QWPalette::QWColor>(key.role), key.tone);
+    const QPixmap result = QPixmap::fromImage(tinted(mask, color));
+    m_cache.insert(key, new QPixmap(result), pixmapCost(result));
+    return result;
+}
+
+} // namespace QtWin
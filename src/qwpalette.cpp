@@ -1,122 +1,178 @@
 #include "QtWin/QWPalette.h"
+#include "qwcolormath_p.h"
+#include "qwquantizer_p.h"
+#include "QtWin/QWLogger.h"
 
+#include <QImageReader>
+
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <limits>
+#include <mutex>
+
+using namespace QtWin::ColorMath;
+
+QWLOGNAME(qtwinPaletteLogger,"qtwin.core.palette")
 
-// Helper constants for D65 white point and sRGB<->XYZ matrices
-static constexpr double D65_X = 95.047, D65_Y = 100.000, D65_Z = 108.883;
-
-// sRGB to XYZ (D65), linear transform coefficients
-static const double SRGB_TO_XYZ[3][3] = {
-    {0.4124, 0.3576, 0.1805},
-    {0.2126, 0.7152, 0.0722},
-    {0.0193, 0.1192, 0.9505}
-};
-// XYZ to sRGB, inverse of above
-static const double XYZ_TO_SRGB[3][3] = {
-    { 3.2406, -1.5372, -0.4986},
-    {-0.9689,  1.8758,  0.0415},
-    { 0.0557, -0.2040,  1.0570}
-};
-
-/** 线性化 sRGB 分量（逆伽马）。 */
-static double linearize(double c) {
-    if (c <= 0.04045) return c / 12.92;
-    return std::pow((c + 0.055) / 1.055, 2.4);
+const double* QtWin::ColorMath::linearizeTable() {
+    struct Table {
+        double value[256];
+        Table() {
+            for (int i = 0; i < 256; ++i) value[i] = linearize(i / 255.0);
+        }
+    };
+    static const Table table;
+    return table.value;
 }
-/** 反线性化 sRGB 分量（伽马校正）。 */
-static double delinearize(double c) {
-    if (c <= 0.0031308) return c * 12.92;
-    return 1.055 * std::pow(c, 1.0/2.4) - 0.055;
+
+QtWin::ColorMath::FixedTables::FixedTables() {
+    for (int i = 0; i < 256; ++i) {
+        linear[i] = Fixed::fromDouble(linearize(i / 255.0)).raw;
+    }
+    for (int i = 0; i < kCbrtSize; ++i) {
+        cbrt[i] = Fixed::fromDouble(std::cbrt(static_cast<double>(i) / (1 << kCbrtBits))).raw;
+    }
+    for (int i = 0; i < kDelinSize; ++i) {
+        delin[i] = static_cast<std::int32_t>(std::lround(delinearize(static_cast<double>(i) / (1 << kDelinBits)) * 255.0 * 256.0));
+    }
+    for (int i = 0; i < kSinSize; ++i) {
+        sinQ[i] = Fixed::fromDouble(std::sin(static_cast<double>(i) / kSinSteps * M_PI / 180.0)).raw;
+    }
+    for (int i = 0; i < 1024; ++i) {
+        sqrtSeed[i] = static_cast<std::uint16_t>(std::lround(std::sqrt(static_cast<double>(i)) * (1 << kSqrtSeedBits)));
+    }
 }
 
-/** XYZ -> Lab 辅助函数 f(t)。 */
-static double pivotLab(double t) {
-    const double delta = 6.0/29.0;
-    if (t > delta*delta*delta) return std::cbrt(t);
-    return t / (3*delta*delta) + 4.0/29.0;
+const QtWin::ColorMath::FixedTables& QtWin::ColorMath::FixedTables::instance() {
+    static const FixedTables tables;
+    return tables;
 }
 
 /** 从 sRGB 颜色计算 HCTColor */
-QtWin::HCTColor QtWin::RGB2HCT(const RGBColor& rgb) {
-    // 1. 归一化并线性化 RGB
-    double r = linearize(rgb.red   / 255.0);
-    double g = linearize(rgb.green / 255.0);
-    double b = linearize(rgb.blue  / 255.0);
-
-    // 2. 线性 RGB -> XYZ (D65)
-    //    计算 X, Y, Z，在转换矩阵作用后乘以100以匹配 Lab 公式
-    double X = (SRGB_TO_XYZ[0][0]*r + SRGB_TO_XYZ[0][1]*g + SRGB_TO_XYZ[0][2]*b) * 100.0;
-    double Y = (SRGB_TO_XYZ[1][0]*r + SRGB_TO_XYZ[1][1]*g + SRGB_TO_XYZ[1][2]*b) * 100.0;
-    double Z = (SRGB_TO_XYZ[2][0]*r + SRGB_TO_XYZ[2][1]*g + SRGB_TO_XYZ[2][2]*b) * 100.0;
-
-    // 3. XYZ -> Lab
-    double xn = X / D65_X;
-    double yn = Y / D65_Y;
-    double zn = Z / D65_Z;
-    double fx = pivotLab(xn);
-    double fy = pivotLab(yn);
-    double fz = pivotLab(zn);
-    double L = 116.0 * fy - 16.0;
-    double a = 500.0 * (fx - fy);
-    double b_val = 200.0 * (fy - fz);
-    // 将 Lab 的 L* 作为 HCT 的 Tone
-    double tone = L;
-
-    // 4. 从 Lab 的 a*, b* 计算 Hue 和 Chroma（CIELCh 角度和值）
-    double hue = std::atan2(b_val, a) * 180.0 / M_PI;  // atan2 返回弧度
-    if (hue < 0) hue += 360.0;
-    double chroma = std::sqrt(a*a + b_val*b_val);
-
-    return { hue, chroma, tone };
+QtWin::HCTColor QtWin::RGB2HCT(const RGBColor& rgb, ColorPrecision precision) {
+    switch (precision) {
+        case ColorPrecision::Float: return rgbToHct<float>(rgb);
+        case ColorPrecision::Fixed: return rgbToHct<Fixed>(rgb);
+        case ColorPrecision::Exact: break;
+    }
+    return rgbToHct<double>(rgb);
+}
+
+namespace {
+    template<typename T>
+    void rgbToHctBatch(const QtWin::RGBColor* rgb, QtWin::HCTColor* hct, qsizetype count) {
+        for (qsizetype i = 0; i < count; ++i) hct[i] = rgbToHct<T>(rgb[i]);
+    }
+
+    template<typename T>
+    void hctToRgbBatch(const QtWin::HCTColor* hct, QtWin::RGBColor* rgb, qsizetype count, QtWin::GamutMapping mapping) {
+        for (qsizetype i = 0; i < count; ++i) rgb[i] = hctToRgb<T>(hct[i], mapping);
+    }
+}
+
+void QtWin::RGB2HCT(const RGBColor* rgb, HCTColor* hct, qsizetype count, ColorPrecision precision) {
+    switch (precision) {
+        case ColorPrecision::Float: rgbToHctBatch<float>(rgb, hct, count); return;
+        case ColorPrecision::Fixed: rgbToHctBatch<Fixed>(rgb, hct, count); return;
+        case ColorPrecision::Exact: break;
+    }
+    rgbToHctBatch<double>(rgb, hct, count);
+}
+
+namespace {
+    /**
+     * 色相 × 色调 最大彩度表。
+     * 色相步长 1°（第 360 列即第 0 列，方便插值回绕），色调步长 1。
+     * 每个格点用二分法精确求出 sRGB 边界。整张表按色相列惰性构建：
+     * 一个调色板只会用到少数几个色相，不必在首次调用时付出整表的代价。
+     */
+    class MaxChromaTable {
+    public:
+        static constexpr int kHueSteps = 360;
+        static constexpr int kToneSteps = 100;
+
+        double lookup(double hue, double tone) const {
+            const int h0 = std::min(static_cast<int>(hue), kHueSteps - 1);
+            const int t0 = std::min(static_cast<int>(tone), kToneSteps - 1);
+            const double dh = hue - h0;
+            const double dt = tone - t0;
+            const float* col0 = column(h0);
+            const float* col1 = column((h0 + 1) % kHueSteps);
+            const double c0 = col0[t0] * (1.0 - dt) + col0[t0 + 1] * dt;
+            const double c1 = col1[t0] * (1.0 - dt) + col1[t0 + 1] * dt;
+            return c0 * (1.0 - dh) + c1 * dh;
+        }
+
+    private:
+        const float* column(int h) const {
+            if (!m_ready[h].load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_ready[h].load(std::memory_order_relaxed)) {
+                    const double rad = h * M_PI / 180.0;
+                    const double cosH = std::cos(rad);
+                    const double sinH = std::sin(rad);
+                    for (int t = 0; t <= kToneSteps; ++t) {
+                        m_chroma[h][t] = static_cast<float>(solve(t, cosH, sinH));
+                    }
+                    m_ready[h].store(true, std::memory_order_release);
+                }
+            }
+            return m_chroma[h];
+        }
+
+        static double solve(double tone, double cosH, double sinH) {
+            if (tone <= 0.0 || tone >= 100.0) return 0.0;
+            // sRGB 在 Lab 中的最大彩度约为 134（蓝色），200 足够作为上界
+            double lo = 0.0, hi = 200.0;
+            for (int i = 0; i < 20; ++i) {
+                const double mid = (lo + hi) * 0.5;
+                if (isInGamut(tone, mid, cosH, sinH)) lo = mid;
+                else hi = mid;
+            }
+            return lo;
+        }
+
+        mutable float m_chroma[kHueSteps][kToneSteps + 1] = {};
+        mutable std::atomic<bool> m_ready[kHueSteps] = {};
+        mutable std::mutex m_mutex;
+    };
+
+    const MaxChromaTable& maxChromaTable() {
+        // 函数内静态变量，C++11 起初始化是线程安全的
+        static const MaxChromaTable table;
+        return table;
+    }
+}
+
+double QtWin::ColorMath::maxChromaEstimate(double hue, double tone) {
+    return maxChromaTable().lookup(hue, tone);
+}
+
+double QtWin::maxChroma(double hue, double tone) {
+    normalizeHueTone(hue, tone);
+    return maxChromaTable().lookup(hue, tone);
 }
 
 /** 从 HCTColor 生成 sRGB 颜色 */
-QtWin::RGBColor QtWin::HCT2RGB(const HCTColor& hct) {
-    double hue = hct.hue;
-    double chroma = hct.chroma;
-    double tone = hct.tone;
-
-    // 限定 hue 在 [0,360)，tone 在 [0,100]
-    if (hue < 0) hue = std::fmod(hue, 360.0) + 360.0;
-    if (hue >= 360) hue = std::fmod(hue, 360.0);
-    if (tone < 0) tone = 0;
-    if (tone > 100) tone = 100;
-
-    // 5. 构造 Lab 空间中对应的色度和色相
-    //    L* = tone, a* = C * cos(hue), b* = C * sin(hue)
-    double L = tone;
-    double a = chroma * std::cos(hue * M_PI/180.0);
-    double b_val = chroma * std::sin(hue * M_PI/180.0);
-
-    // 6. Lab -> XYZ
-    double fy = (L + 16.0) / 116.0;
-    double fx = fy + (a / 500.0);
-    double fz = fy - (b_val / 200.0);
-    double fx3 = fx*fx*fx;
-    double fz3 = fz*fz*fz;
-    double fy3 = fy*fy*fy;
-    const double eps = 216.0/24389.0; // = (6/29)^3
-    const double kappa = 24389.0/27.0; // = (29/3)^3
-
-    double xr = (fx3 > eps) ? fx3 : (116.0*fx - 16.0) / kappa;
-    double yr = (L > (kappa * eps)) ? fy3 : L / kappa;
-    double zr = (fz3 > eps) ? fz3 : (116.0*fz - 16.0) / kappa;
-    double X = xr * D65_X;
-    double Y = yr * D65_Y;
-    double Z = zr * D65_Z;
-
-    // 7. XYZ -> 线性 RGB
-    double lr = (XYZ_TO_SRGB[0][0]*X + XYZ_TO_SRGB[0][1]*Y + XYZ_TO_SRGB[0][2]*Z) / 100.0;
-    double lg = (XYZ_TO_SRGB[1][0]*X + XYZ_TO_SRGB[1][1]*Y + XYZ_TO_SRGB[1][2]*Z) / 100.0;
-    double lb = (XYZ_TO_SRGB[2][0]*X + XYZ_TO_SRGB[2][1]*Y + XYZ_TO_SRGB[2][2]*Z) / 100.0;
-
-    // 8. 反线性化并量化到 [0,255]
-    int R = std::lround(std::clamp(delinearize(lr), 0.0, 1.0) * 255.0);
-    int G = std::lround(std::clamp(delinearize(lg), 0.0, 1.0) * 255.0);
-    int B = std::lround(std::clamp(delinearize(lb), 0.0, 1.0) * 255.0);
-
-    return { R, G, B };
+QtWin::RGBColor QtWin::HCT2RGB(const HCTColor& hct, GamutMapping mapping, ColorPrecision precision) {
+    switch (precision) {
+        case ColorPrecision::Float: return hctToRgb<float>(hct, mapping);
+        case ColorPrecision::Fixed: return hctToRgb<Fixed>(hct, mapping);
+        case ColorPrecision::Exact: break;
+    }
+    return hctToRgb<double>(hct, mapping);
 }
+
+void QtWin::HCT2RGB(const HCTColor* hct, RGBColor* rgb, qsizetype count, GamutMapping mapping, ColorPrecision precision) {
+    switch (precision) {
+        case ColorPrecision::Float: hctToRgbBatch<float>(hct, rgb, count, mapping); return;
+        case ColorPrecision::Fixed: hctToRgbBatch<Fixed>(hct, rgb, count, mapping); return;
+        case ColorPrecision::Exact: break;
+    }
+    hctToRgbBatch<double>(hct, rgb, count, mapping);
+}
+
 QtWin::RGBColor::RGBColor():RGBColor(0,0,0){}
 QtWin::RGBColor::RGBColor(int red,int green,int blue):red(red),green(green),blue(blue){}
 QtWin::RGBColor::RGBColor(QColor qcolor):red(qcolor.red()),green(qcolor.green()),blue(qcolor.blue()){}
@@ -136,6 +192,23 @@ QtWin::QWPalette::QWPalette(HCTColor hct) : basicColor(hct){
     palette[4] = accentColor;
 }
 
+QtWin::QWPalette::QWPalette(const QWPalette& other)
+    : basicColor(other.basicColor),
+    mapping(other.mapping),
+    luminance(std::atomic_load(&other.luminance)){
+    std::copy(std::begin(other.palette), std::end(other.palette), std::begin(palette));
+}
+
+QtWin::QWPalette& QtWin::QWPalette::operator=(const QWPalette& other){
+    if (this != &other) {
+        basicColor = other.basicColor;
+        std::copy(std::begin(other.palette), std::end(other.palette), std::begin(palette));
+        mapping = other.mapping;
+        std::atomic_store(&luminance, std::atomic_load(&other.luminance));
+    }
+    return *this;
+}
+
 void QtWin::QWPalette::setSeedColor(RGBColor rgb){
     this->setSeedColor(RGB2HCT(rgb));
 }
@@ -151,6 +224,15 @@ void QtWin::QWPalette::setSeedColor(HCTColor hct){
     palette[2] = neutralColor;
     palette[3] = neutralAccent;
     palette[4] = accentColor;
+    std::atomic_store(&luminance, std::shared_ptr<const LuminanceTable>());
+}
+
+void QtWin::QWPalette::setGamutMapping(GamutMapping mapping){
+    this->mapping = mapping;
+    std::atomic_store(&luminance, std::shared_ptr<const LuminanceTable>());
+}
+QtWin::GamutMapping QtWin::QWPalette::gamutMapping() const{
+    return this->mapping;
 }
 
 QtWin::HCTColor QtWin::QWPalette::getHCTColor(QWColor n,int tone)const{
@@ -159,72 +241,94 @@ QtWin::HCTColor QtWin::QWPalette::getHCTColor(QWColor n,int tone)const{
 }
 QtWin::RGBColor QtWin::QWPalette::getRGBColor(QWColor n,int tone)const{
     const HCTColor hct = this->getHCTColor(n,tone);
-    return HCT2RGB(hct);
+    return HCT2RGB(hct,this->mapping);
 }
 QColor QtWin::QWPalette::getQColor(QWColor n,int tone)const{
     const RGBColor rgb = this->getRGBColor(n,tone);
     return QColor(rgb.red,rgb.green,rgb.blue);
 }
 
-//Extract color from picture
-namespace QtWin{
-    namespace Monet{
-        //Hide details
-        static void quantizeImageColors(const QImage& image,std::vector<int>& colorCount){
-            //固定4096个桶
-            const int kBins = 4096;
-
-            //初始化桶
-            if(colorCount.size() != kBins){
-                colorCount.assign(kBins, 0);
+const QtWin::QWPalette::LuminanceTable& QtWin::QWPalette::luminanceTable()const{
+    std::shared_ptr<const LuminanceTable> table = std::atomic_load(&this->luminance);
+    if (!table) {
+        auto built = std::make_shared<LuminanceTable>();
+        HCTColor hct[101];
+        RGBColor rgb[101];
+        for (int role = 0; role < 5; ++role) {
+            for (int tone = 0; tone <= 100; ++tone) {
+                hct[tone] = this->getHCTColor(static_cast<QWColor>(role), tone);
             }
-
-            //处理图像缩放
-            constexpr int kMaxDimension = 256;
-            int width = image.width();
-            int height = image.height();
-            int scaledWidth = width;
-            int scaledHeight = height;
-            if (width > kMaxDimension || height > kMaxDimension) {
-                if (width > height) {
-                    scaledWidth = kMaxDimension;
-                    scaledHeight = (kMaxDimension * height) / width;
-                } else {
-                    scaledHeight = kMaxDimension;
-                    scaledWidth = (kMaxDimension * width) / height;
-                }
+            HCT2RGB(hct, rgb, 101, this->mapping);
+            const double* linear = linearizeTable();
+            for (int tone = 0; tone <= 100; ++tone) {
+                built->value[role][tone] = 0.2126 * linear[rgb[tone].red]
+                                         + 0.7152 * linear[rgb[tone].green]
+                                         + 0.0722 * linear[rgb[tone].blue];
             }
+        }
+        // 并发构建时只有第一份被采用，其他线程返回已经发布的那份
+        std::shared_ptr<const LuminanceTable> expected;
+        table = built;
+        if (!std::atomic_compare_exchange_strong(&this->luminance, &expected, table)) {
+            table = expected;
+        }
+    }
+    // 表由 luminance 持有，直到 setSeedColor / setGamutMapping 替换它
+    return *table;
+}
 
-            // 转换图像格式
-            QImage img = (image.format() == QImage::Format_ARGB32)
-                ? image
-                : image.convertToFormat(QImage::Format_ARGB32);
+double QtWin::QWPalette::relativeLuminance(QWColor n,int tone)const{
+    return this->luminanceTable().value[n][std::clamp(tone, 0, 100)];
+}
 
-            // 缩放处理
-            if (scaledWidth != width || scaledHeight != height) {
-                img = img.scaled(scaledWidth, scaledHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            }
+int QtWin::QWPalette::toneForContrast(QWColor n,int backgroundTone,double ratio)const{
+    return this->toneForContrast(n, backgroundTone, ratio, n);
+}
 
-            // 遍历
-            for (int y = 0; y < img.height(); ++y) {
-                const QRgb* scanLine = reinterpret_cast<const QRgb*>(img.scanLine(y));
-                for (int x = 0; x < img.width(); ++x) {
-                    QRgb pixel = scanLine[x];
-                    // 跳过完全透明或近乎透明的像素
-                    if (qAlpha(pixel) < 128) {
-                        continue;
-                    }
-                    // 每个通道量化到4位（0-15）
-                    int r = qRed(pixel) >> 4;
-                    int g = qGreen(pixel) >> 4;
-                    int b = qBlue(pixel) >> 4;
-                    // 组合成12位键
-                    int key = (r << 8) | (g << 4) | b;
-                    // 对应桶加1
-                    colorCount[key]++;
-                }
-            }
+int QtWin::QWPalette::toneForContrast(QWColor n,int backgroundTone,double ratio,QWColor backgroundRole,ContrastSearch search)const{
+    const LuminanceTable& table = this->luminanceTable();
+    const double* lum = table.value[n];
+    const double* end = lum + 101;
+    const double background = table.value[backgroundRole][std::clamp(backgroundTone, 0, 100)];
+    ratio = std::max(ratio, 1.0);
+
+    // 亮度随色调单调递增，满足对比度的色调是一段前缀（更暗）或后缀（更亮）
+    const double darkLimit = (background + 0.05) / ratio - 0.05;
+    const double lightLimit = ratio * (background + 0.05) - 0.05;
+    const auto darker = [&]() {
+        // 亮度 <= darkLimit 的最大色调，最接近背景
+        return static_cast<int>(std::upper_bound(lum, end, darkLimit) - lum) - 1;
+    };
+    const auto lighter = [&]() {
+        // 亮度 >= lightLimit 的最小色调
+        const int tone = static_cast<int>(std::lower_bound(lum, end, lightLimit) - lum);
+        return tone <= 100 ? tone : -1;
+    };
+
+    const bool preferDark = search == ContrastSearch::Auto ? backgroundTone >= 50 : search == ContrastSearch::Darker;
+    int tone = preferDark ? darker() : lighter();
+    if (tone >= 0) {
+        return tone;
+    }
+    if (search == ContrastSearch::Auto) {
+        tone = preferDark ? lighter() : darker();
+        if (tone >= 0) {
+            return tone;
         }
+        // 两个方向都达不到：取对比度最高的一端
+        const double black = (background + 0.05) / (lum[0] + 0.05);
+        const double white = (lum[100] + 0.05) / (background + 0.05);
+        return black >= white ? 0 : 100;
+    }
+    return preferDark ? 0 : 100;
+}
+
+//Extract color from picture
+namespace QtWin{
+    namespace Monet{
+        //Hide details
+        // KMeans 的聚类数：远多于最终选出的 5 个颜色，小面积的高彩度颜色也能形成自己的聚类
+        constexpr int kSeedClusters = 16;
 
         static RGBColor keyToRGB(int key) {
             int r = (key >> 8) & 0xF;
@@ -238,54 +342,228 @@ namespace QtWin{
             return color;
         }
 
-        static void pickTopColors(const std::vector<int>& colorCount, std::vector<HCTColor>& outColors, int topN = 5) {
-            struct ScoredColor {
-                double score;
-                HCTColor hct;
+        /** 彩度足够且不过亮、不过暗的颜色才参与主评分。 */
+        static bool isChromatic(const HCTColor& c) {
+            return !(c.chroma < 5.0 || c.tone > 95.0 || c.tone < 5.0);
+        }
+
+        const BinInfo* binTable() {
+            // 桶键到颜色的映射是固定的，之后每次评分都只是对直方图的一次遍历，不再有任何超越函数运算。
+            // 桶中心只用于评分与作为种子，使用 Float 精度（与 Exact 相差不超过 1 个色阶）
+            struct Table {
+                BinInfo bins[4096];
+                Table() {
+                    std::vector<RGBColor> rgb(4096);
+                    std::vector<HCTColor> hct(4096);
+                    for (int key = 0; key < 4096; ++key) rgb[key] = keyToRGB(key);
+                    RGB2HCT(rgb.data(), hct.data(), 4096, ColorPrecision::Float);
+                    for (int key = 0; key < 4096; ++key) {
+                        bins[key] = {hct[key], isChromatic(hct[key])};
+                    }
+                }
             };
+            static const Table table;
+            return table.bins;
+        }
 
-            std::vector<ScoredColor> scored;
-            const int kBins = 4096;
-            for (int key = 0; key < kBins; ++key) {
-                int population = colorCount[key];
-                if (population <= 0) continue;
+        struct ScoredColor {
+            double score;
+            HCTColor hct;
+        };
+
+        /** 从评分列表中选出前 topN 个颜色；需要裕量时多排一名。 */
+        static void selectTopColors(std::vector<ScoredColor>& scored, bool grayFallback,
+                                    std::vector<HCTColor>& outColors, ScoreMargin* margin, int topN) {
+            const int count = std::min<int>(topN, static_cast<int>(scored.size()));
+            const int ranked = margin ? std::min<int>(count + 1, static_cast<int>(scored.size())) : count;
+            std::partial_sort(scored.begin(), scored.begin() + ranked, scored.end(),
+                            [](const ScoredColor& a, const ScoredColor& b) {
+                                return a.score > b.score;
+                            });
 
-                RGBColor rgb = keyToRGB(key);
-                HCTColor hct = RGB2HCT(rgb);
+            outColors.clear();
+            for (int i = 0; i < count; ++i) {
+                outColors.push_back(scored[i].hct);
+            }
 
-                if (hct.chroma < 5.0 || hct.tone > 95.0 || hct.tone < 5.0) continue;
+            if (margin) {
+                margin->grayFallback = grayFallback;
+                margin->margin = count > 0 ? std::numeric_limits<double>::max() : 0.0;
+                for (int i = 0; i < count; ++i) {
+                    const double next = i + 1 < ranked ? scored[i + 1].score : 0.0;
+                    margin->margin = std::min(margin->margin, scored[i].score - next);
+                }
+            }
+        }
 
-                double score = static_cast<double>(population) * hct.chroma;
-                scored.push_back({score, hct});
+        template<typename Count>
+        static void rankTopColors(const std::vector<Count>& colorCount, std::vector<HCTColor>& outColors,
+                                  ScoreMargin* margin = nullptr, int topN = 5) {
+            const int kBins = kHistogramBins;
+            const BinInfo* bins = binTable();
+            std::vector<ScoredColor> scored;
+            scored.reserve(256);
+            for (int key = 0; key < kBins; ++key) {
+                const Count population = colorCount[key];
+                if (population <= 0 || !bins[key].chromatic) continue;
+                scored.push_back({static_cast<double>(population) * bins[key].hct.chroma, bins[key].hct});
             }
 
             // 处理灰阶兜底
-            if (scored.empty()) {
+            const bool grayFallback = scored.empty();
+            if (grayFallback) {
                 for (int key = 0; key < kBins; ++key) {
                     if (colorCount[key] > 0) {
-                        RGBColor rgb = keyToRGB(key);
-                        HCTColor hct = RGB2HCT(rgb);
-                        scored.push_back((ScoredColor){colorCount[key], hct});
+                        scored.push_back({static_cast<double>(colorCount[key]), bins[key].hct});
                     }
                 }
             }
+            selectTopColors(scored, grayFallback, outColors, margin, topN);
+        }
 
-            // 选出前 topN 个颜色
-            std::partial_sort(scored.begin(), scored.begin() + std::min<int>(topN, scored.size()), scored.end(),
-                            [](const ScoredColor& a, const ScoredColor& b) {
-                                return a.score > b.score;
-                            });
+        /** 与 rankTopColors 相同的评分，作用于任意深度的桶或聚类。 */
+        static void rankWeightedColors(const std::vector<WeightedColor>& colors, std::vector<HCTColor>& outColors,
+                                       int topN = 5) {
+            std::vector<ScoredColor> scored;
+            scored.reserve(colors.size());
+            for (const WeightedColor& color : colors) {
+                if (color.weight > 0.0 && isChromatic(color.hct)) {
+                    scored.push_back({color.weight * color.hct.chroma, color.hct});
+                }
+            }
+            const bool grayFallback = scored.empty();
+            if (grayFallback) {
+                for (const WeightedColor& color : colors) {
+                    if (color.weight > 0.0) {
+                        scored.push_back({color.weight, color.hct});
+                    }
+                }
+            }
+            selectTopColors(scored, grayFallback, outColors, nullptr, topN);
+        }
 
-            outColors.clear();
-            for (int i = 0; i < std::min<int>(topN, scored.size()); ++i) {
-                outColors.push_back(scored[i].hct);
+        /** 非空桶的中心颜色，以像素数为权重。 */
+        static std::vector<WeightedColor> binColors(const std::vector<ColorBin>& bins, int bits) {
+            std::vector<WeightedColor> colors(bins.size());
+            if (bits == 4) {
+                const BinInfo* table = binTable();
+                for (size_t i = 0; i < bins.size(); ++i) {
+                    colors[i] = {table[bins[i].key].hct, static_cast<double>(bins[i].count)};
+                }
+                return colors;
             }
+            std::vector<RGBColor> rgb(bins.size());
+            std::vector<HCTColor> hct(bins.size());
+            for (size_t i = 0; i < bins.size(); ++i) rgb[i] = binCenter(bins[i].key, bits);
+            // 与 binTable 相同的 Float 精度；细粒度的桶每张图片都要转换，是逐像素级的工作量
+            RGB2HCT(rgb.data(), hct.data(), static_cast<qsizetype>(bins.size()), ColorPrecision::Float);
+            for (size_t i = 0; i < bins.size(); ++i) {
+                colors[i] = {hct[i], static_cast<double>(bins[i].count)};
+            }
+            return colors;
+        }
+
+        void pickTopColors(const std::vector<double>& weights, std::vector<HCTColor>& colorSet,
+                           ScoreMargin* margin) {
+            rankTopColors(weights, colorSet, margin);
         }
     }
 
     void extractSeedColor(const QImage& image, std::vector<HCTColor>& colorSet) {
-        std::vector<int> colorCount;
-        Monet::quantizeImageColors(image, colorCount);
-        Monet::pickTopColors(colorCount, colorSet);
+        extractSeedColor(image, colorSet, SeedExtractionOptions());
+    }
+
+    void extractSeedColor(const QImage& image, std::vector<HCTColor>& colorSet,
+                        const SeedExtractionOptions& options) {
+        Monet::extractSeedColor(image, colorSet, options, Monet::CancelCheck());
+    }
+
+    bool Monet::extractSeedColor(const QImage& image, std::vector<HCTColor>& colorSet,
+                                 const SeedExtractionOptions& options, const CancelCheck& canceled,
+                                 std::vector<int>* histogram) {
+        const int bits = binBits(options);
+        if (bits == 4 && options.quantizer == SeedQuantizer::Histogram) {
+            std::vector<int> local;
+            std::vector<int>& colorCount = histogram ? *histogram : local;
+            std::fill(colorCount.begin(), colorCount.end(), 0); // 复用的缓冲区先清零
+            if (!quantizeImageColors(image, colorCount, options, canceled)) {
+                return false;
+            }
+            rankTopColors(colorCount, colorSet);
+            return true;
+        }
+
+        // 更细的桶或聚类：只处理非空的桶
+        std::vector<ColorBin> bins;
+        if (!quantizeImageBins(image, bins, options, canceled)) {
+            return false;
+        }
+        std::vector<WeightedColor> colors = binColors(bins, bits);
+        if (options.quantizer == SeedQuantizer::KMeans) {
+            std::vector<WeightedColor> clusters;
+            clusterColors(colors, kSeedClusters, clusters);
+            colors.swap(clusters);
+        }
+        rankWeightedColors(colors, colorSet);
+        return true;
+    }
+
+    namespace Monet{
+        /**
+         * 以采样网格的分辨率解码。
+         * 支持 ScaledSize 的格式（如 JPEG 在 DCT 域缩小）直接解码出网格大小的图像，
+         * 不会在内存中出现完整分辨率的位图；其余格式完整解码一次后原地采样。
+         */
+        static bool extractFromReader(QImageReader& reader, std::vector<HCTColor>& colorSet,
+                                      const SeedExtractionOptions& options,
+                                      const CancelCheck& canceled = CancelCheck(),
+                                      std::vector<int>* histogram = nullptr) {
+            reader.setAutoTransform(false); // 方向不影响颜色统计
+            const QSize size = reader.size();
+            if (options.maxDimension > 0 && size.isValid()
+                && (size.width() > options.maxDimension || size.height() > options.maxDimension)
+                && reader.supportsOption(QImageIOHandler::ScaledSize)) {
+                reader.setScaledSize(size.scaled(options.maxDimension, options.maxDimension, Qt::KeepAspectRatio));
+            }
+
+            const QImage image = reader.read();
+            if (image.isNull()) {
+                qwLogger(LogLevel::Warning,qtwinPaletteLogger)<<"Failed to decode image for seed extraction:"<<reader.errorString();
+                colorSet.clear();
+                return false;
+            }
+
+            // 未能在解码时缩小的图像不再做平滑缩放，直接在原图上采样
+            SeedExtractionOptions sampling = options;
+            if (sampling.sampling == SeedSampling::Smooth && reader.scaledSize().isEmpty()) {
+                sampling.sampling = SeedSampling::Strided;
+            }
+            return extractSeedColor(image, colorSet, sampling, canceled, histogram);
+        }
+
+        bool extractSeedColorFromFile(const QString& path, std::vector<HCTColor>& colorSet,
+                                      const SeedExtractionOptions& options, const CancelCheck& canceled) {
+            QImageReader reader(path);
+            return extractFromReader(reader, colorSet, options, canceled);
+        }
+
+        bool extractSeedColorFromDevice(QIODevice* device, std::vector<HCTColor>& colorSet,
+                                        const SeedExtractionOptions& options, const CancelCheck& canceled,
+                                        std::vector<int>* histogram) {
+            QImageReader reader(device);
+            return extractFromReader(reader, colorSet, options, canceled, histogram);
+        }
+    }
+
+    bool extractSeedColorFromFile(const QString& path, std::vector<HCTColor>& colorSet,
+                                const SeedExtractionOptions& options) {
+        QImageReader reader(path);
+        return Monet::extractFromReader(reader, colorSet, options);
+    }
+
+    bool extractSeedColor(QIODevice* device, std::vector<HCTColor>& colorSet,
+                        const SeedExtractionOptions& options) {
+        QImageReader reader(device);
+        return Monet::extractFromReader(reader, colorSet, options);
     }
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "QtWin/QWPaletteCache.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace QtWin {
+
+QWToneTable::QWToneTable(const QWPalette& palette) {
+    for (int role = 0; role < kRoleCount; ++role) {
+        for (int tone = 0; tone < kToneCount; ++tone) {
+            const RGBColor rgb = palette.getRGBColor(static_cast<QWPalette::QWColor>(role), tone);
+            m_table[role][tone] = qRgb(rgb.red, rgb.green, rgb.blue);
+        }
+    }
+}
+
+QWToneTable::QWToneTable(const QRgb* values) {
+    std::copy(values, values + kRoleCount * kToneCount, &m_table[0][0]);
+}
+
+const QRgb* QWToneTable::data() const {
+    return &m_table[0][0];
+}
+
+QRgb QWToneTable::rgb(QWPalette::QWColor role, int tone) const {
+    return m_table[role][std::clamp(tone, 0, kToneCount - 1)];
+}
+
+QColor QWToneTable::color(QWPalette::QWColor role, int tone) const {
+    return QColor(rgb(role, tone));
+}
+
+bool QWPaletteCache::Key::operator==(const Key& other) const {
+    return seed == other.seed
+        && lightTone == other.lightTone
+        && darkTone == other.darkTone
+        && mapping == other.mapping;
+}
+
+size_t qHash(const QWPaletteCache::Key& key, size_t seed) noexcept {
+    return qHashMulti(seed, key.seed, key.lightTone, key.darkTone, static_cast<int>(key.mapping));
+}
+
+bool QWPaletteCache::PaletteKey::operator==(const PaletteKey& other) const {
+    return seed == other.seed && mapping == other.mapping;
+}
+
+size_t qHash(const QWPaletteCache::PaletteKey& key, size_t seed) noexcept {
+    return qHashMulti(seed, key.seed, static_cast<int>(key.mapping));
+}
+
+QWPaletteCache& QWPaletteCache::instance() {
+    static QWPaletteCache cache;
+    return cache;
+}
+
+QWPaletteCache::Entry QWPaletteCache::acquire(const QColor& seed, int lightTone, int darkTone,
+                                            GamutMapping mapping) {
+    const Key key{seed.rgb(), lightTone, darkTone, mapping};
+
+    {
+        const QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            // 命中：移动到 LRU 头部
+            m_lru.splice(m_lru.begin(), m_lru, it->lruPos);
+            return it->entry;
+        }
+
+        // 调色板本身与色调设置无关：如果已有相同种子和变体的条目，
+        // 直接共享其调色板与色调表，只为新的色调组合新增一个键。
+        auto shared = m_palettes.constFind(PaletteKey{key.seed, key.mapping});
+        if (shared != m_palettes.constEnd()) {
+            const Entry entry = shared->entry;
+            add(key, entry);
+            return entry;
+        }
+    }
+
+    // 未命中：在锁外完成颜色转换，避免阻塞其他线程的查找
+    auto palette = QSharedPointer<QWPalette>::create(RGBColor(seed));
+    palette->setGamutMapping(mapping);
+    Entry entry;
+    entry.tones = QSharedPointer<const QWToneTable>::create(*palette);
+    entry.palette = palette;
+
+    const QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        // 其他线程已经抢先插入，使用已有对象以保证共享
+        m_lru.splice(m_lru.begin(), m_lru, it->lruPos);
+        return it->entry;
+    }
+    add(key, entry);
+    return entry;
+}
+
+QWPaletteCache::Entry QWPaletteCache::insert(const QColor& seed, int lightTone, int darkTone, const Entry& entry,
+                                           GamutMapping mapping) {
+    const Key key{seed.rgb(), lightTone, darkTone, mapping};
+    const QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->lruPos);
+        return it->entry;
+    }
+    add(key, entry);
+    return entry;
+}
+
+void QWPaletteCache::setCapacity(int capacity) {
+    const QMutexLocker locker(&m_mutex);
+    m_capacity = std::max(1, capacity);
+    trim();
+}
+
+int QWPaletteCache::capacity() const {
+    const QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+int QWPaletteCache::size() const {
+    const QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_entries.size());
+}
+
+void QWPaletteCache::clear() {
+    const QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_palettes.clear();
+    m_lru.clear();
+}
+
+void QWPaletteCache::add(const Key& key, const Entry& entry) {
+    // 调用方必须持有 m_mutex，且 key 不在缓存中
+    m_lru.push_front(key);
+    m_entries.insert(key, Node{entry, m_lru.begin()});
+    auto shared = m_palettes.find(PaletteKey{key.seed, key.mapping});
+    if (shared == m_palettes.end()) {
+        m_palettes.insert(PaletteKey{key.seed, key.mapping}, SharedPalette{entry, 1});
+    } else {
+        ++shared->keys;
+    }
+    trim();
+}
+
+void QWPaletteCache::trim() {
+    // 调用方必须持有 m_mutex
+    while (static_cast<int>(m_lru.size()) > m_capacity) {
+        const Key& key = m_lru.back();
+        auto shared = m_palettes.find(PaletteKey{key.seed, key.mapping});
+        if (shared != m_palettes.end() && --shared->keys == 0) {
+            m_palettes.erase(shared);
+        }
+        m_entries.remove(key);
+        m_lru.pop_back();
+    }
+}
+
+} // namespace QtWin
@@ -0,0 +1,793 @@
+#include "qwquantizer_p.h"
+#include "qwcpufeatures_p.h"
+
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace QtWin {
+namespace Monet {
+
+namespace {
+
+// 小于该工作量（读取的像素数）时直接在调用线程完成，线程调度的开销不值得
+constexpr qint64 kMinParallelPixels = 512 * 512;
+// 每个任务块大约读取的像素数，块数多于线程数以便负载均衡
+constexpr qint64 kChunkPixels = 64 * 1024;
+
+/*
+ * 扫描行量化内核。
+ * 每个像素的 12 位键为 ((p >> 12) & 0xF00) | ((p >> 8) & 0xF0) | ((p >> 4) & 0xF)，
+ * alpha < 128（即最高位为 0）的像素计入不参与结果的哑桶 kDummyBin，避免分支。
+ * 相邻像素轮流写入 kLanes 个子直方图：大片纯色区域里连续的相同键不会在
+ * 同一个计数器上形成写后读依赖，最后再合并。
+ */
+constexpr int kLanes = 4;
+constexpr int kDummyBin = kHistogramBins;
+
+struct SubHistograms {
+    std::uint32_t bins[kLanes][kHistogramBins + 1] = {};
+};
+
+using ScanlineKernel = void (*)(const QRgb* pixels, int count, SubHistograms& counts);
+
+inline std::uint32_t pixelKey(QRgb pixel) {
+    const std::uint32_t key = ((pixel >> 12) & 0xF00) | ((pixel >> 8) & 0xF0) | ((pixel >> 4) & 0xF);
+    const std::uint32_t opaque = 0u - (pixel >> 31); // alpha >= 128 时全 1，不用分支
+    return kDummyBin ^ ((kDummyBin ^ key) & opaque);
+}
+
+void quantizeScalar(const QRgb* pixels, int count, SubHistograms& counts) {
+    int x = 0;
+    for (; x + kLanes <= count; x += kLanes) {
+        for (int lane = 0; lane < kLanes; ++lane) {
+            counts.bins[lane][pixelKey(pixels[x + lane])]++;
+        }
+    }
+    for (; x < count; ++x) {
+        counts.bins[0][pixelKey(pixels[x])]++;
+    }
+}
+
+#ifdef QTWIN_X86
+
+QTWIN_TARGET("sse4.1")
+inline __m128i keys4(__m128i pixels) {
+    const __m128i key = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 12), _mm_set1_epi32(0xF00)),
+                     _mm_and_si128(_mm_srli_epi32(pixels, 8), _mm_set1_epi32(0xF0))),
+        _mm_and_si128(_mm_srli_epi32(pixels, 4), _mm_set1_epi32(0xF)));
+    // blendv 按每个 32 位元素的最高位（即 alpha 的最高位）选择
+    return _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(_mm_set1_epi32(kDummyBin)),
+                                          _mm_castsi128_ps(key),
+                                          _mm_castsi128_ps(pixels)));
+}
+
+QTWIN_TARGET("sse4.1")
+void quantizeSse41(const QRgb* pixels, int count, SubHistograms& counts) {
+    alignas(16) std::uint32_t keys[8];
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(keys),
+                        keys4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x))));
+        _mm_store_si128(reinterpret_cast<__m128i*>(keys + 4),
+                        keys4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x + 4))));
+        for (int i = 0; i < 8; ++i) {
+            counts.bins[i % kLanes][keys[i]]++;
+        }
+    }
+    quantizeScalar(pixels + x, count - x, counts);
+}
+
+QTWIN_TARGET("avx2")
+inline __m256i keys8(__m256i pixels) {
+    const __m256i key = _mm256_or_si256(
+        _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(pixels, 12), _mm256_set1_epi32(0xF00)),
+                        _mm256_and_si256(_mm256_srli_epi32(pixels, 8), _mm256_set1_epi32(0xF0))),
+        _mm256_and_si256(_mm256_srli_epi32(pixels, 4), _mm256_set1_epi32(0xF)));
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(_mm256_set1_epi32(kDummyBin)),
+                                                _mm256_castsi256_ps(key),
+                                                _mm256_castsi256_ps(pixels)));
+}
+
+QTWIN_TARGET("avx2")
+void quantizeAvx2(const QRgb* pixels, int count, SubHistograms& counts) {
+    alignas(32) std::uint32_t keys[16];
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(keys),
+                           keys8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x))));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(keys + 8),
+                           keys8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x + 8))));
+        for (int i = 0; i < 16; ++i) {
+            counts.bins[i % kLanes][keys[i]]++;
+        }
+    }
+    quantizeScalar(pixels + x, count - x, counts);
+}
+
+#endif // QTWIN_X86
+
+ScanlineKernel selectKernel() {
+#ifdef QTWIN_X86
+    if (Cpu::hasAvx2()) return quantizeAvx2;
+    if (Cpu::hasSse41()) return quantizeSse41;
+#endif
+    return quantizeScalar;
+}
+
+/** 可以原地读取的源像素布局。 */
+enum class PixelLayout {
+    Argb32,                // RGB32 / ARGB32
+    Argb32Premultiplied,   // ARGB32_Premultiplied
+    Rgba8888,              // RGBA8888 / RGBX8888
+    Rgba8888Premultiplied, // RGBA8888_Premultiplied
+    Rgb888                 // RGB888
+};
+
+bool layoutFor(QImage::Format format, PixelLayout& layout) {
+    switch (format) {
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32:
+            layout = PixelLayout::Argb32;
+            return true;
+        case QImage::Format_ARGB32_Premultiplied:
+            layout = PixelLayout::Argb32Premultiplied;
+            return true;
+        case QImage::Format_RGBX8888:
+        case QImage::Format_RGBA8888:
+            layout = PixelLayout::Rgba8888;
+            return true;
+        case QImage::Format_RGBA8888_Premultiplied:
+            layout = PixelLayout::Rgba8888Premultiplied;
+            return true;
+        case QImage::Format_RGB888:
+            layout = PixelLayout::Rgb888;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** 读取扫描行上第 x 个像素，统一为非预乘的 ARGB32。 */
+template<PixelLayout L>
+inline QRgb fetchPixel(const uchar* line, int x) {
+    if constexpr (L == PixelLayout::Argb32) {
+        return reinterpret_cast<const QRgb*>(line)[x];
+    } else if constexpr (L == PixelLayout::Argb32Premultiplied) {
+        return qUnpremultiply(reinterpret_cast<const QRgb*>(line)[x]);
+    } else if constexpr (L == PixelLayout::Rgba8888) {
+        const uchar* p = line + 4 * x;
+        return qRgba(p[0], p[1], p[2], p[3]);
+    } else if constexpr (L == PixelLayout::Rgba8888Premultiplied) {
+        const uchar* p = line + 4 * x;
+        return qUnpremultiply(qRgba(p[0], p[1], p[2], p[3]));
+    } else {
+        const uchar* p = line + 3 * x;
+        return qRgb(p[0], p[1], p[2]);
+    }
+}
+
+/**
+ * 5、6 位深度的稀疏直方图：开放寻址哈希表，只为出现过的桶分配存储。
+ * 一次采样最多只有几万种颜色，稠密数组（最大 262144 项）的清零、合并和遍历都远比这更慢。
+ */
+template<int Bits>
+class SparseHistogram {
+public:
+    static_assert(BinDepth<Bits>::kSparse, "4-bit histograms are dense");
+
+    SparseHistogram() : m_keys(kInitialCapacity, kEmpty), m_counts(kInitialCapacity, 0) {}
+
+    void add(const QRgb* pixels, int count) {
+        for (int i = 0; i < count; ++i) {
+            const QRgb pixel = pixels[i];
+            if ((pixel >> 31) == 0) {
+                continue; // alpha < 128
+            }
+            const quint32 key = BinDepth<Bits>::key(pixel);
+            if (key == m_lastKey) {
+                ++m_counts[m_lastSlot]; // 大片相同颜色无需查表
+                continue;
+            }
+            m_lastSlot = insert(key, 1);
+            m_lastKey = key;
+        }
+    }
+
+    void merge(const SparseHistogram& other) {
+        for (std::size_t slot = 0; slot < other.m_keys.size(); ++slot) {
+            if (other.m_keys[slot] != kEmpty) {
+                insert(other.m_keys[slot], other.m_counts[slot]);
+            }
+        }
+    }
+
+    void collect(std::vector<ColorBin>& bins) const {
+        bins.reserve(bins.size() + m_size);
+        for (std::size_t slot = 0; slot < m_keys.size(); ++slot) {
+            if (m_keys[slot] != kEmpty) {
+                bins.push_back({m_keys[slot], m_counts[slot]});
+            }
+        }
+        // 输出顺序与哈希布局无关，串行与并行的结果完全相同
+        std::sort(bins.begin(), bins.end(), [](const ColorBin& a, const ColorBin& b) { return a.key < b.key; });
+    }
+
+private:
+    static constexpr quint32 kEmpty = 0xFFFFFFFFu;
+    static constexpr int kInitialBits = 10;
+    static constexpr std::size_t kInitialCapacity = std::size_t(1) << kInitialBits;
+
+    std::size_t find(quint32 key) const {
+        const std::size_t mask = m_keys.size() - 1;
+        std::size_t slot = (key * 2654435761u) >> m_shift; // Fibonacci 哈希取高位
+        while (m_keys[slot] != kEmpty && m_keys[slot] != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    std::size_t insert(quint32 key, int count) {
+        std::size_t slot = find(key);
+        if (m_keys[slot] == kEmpty) {
+            if ((m_size + 1) * 2 > m_keys.size()) {
+                grow();
+                slot = find(key);
+            }
+            m_keys[slot] = key;
+            ++m_size;
+        }
+        m_counts[slot] += count;
+        return slot;
+    }
+
+    void grow() {
+        std::vector<quint32> keys(m_keys.size() * 2, kEmpty);
+        std::vector<int> counts(m_keys.size() * 2, 0);
+        keys.swap(m_keys);
+        counts.swap(m_counts);
+        --m_shift;
+        m_size = 0;
+        m_lastKey = kEmpty;
+        for (std::size_t slot = 0; slot < keys.size(); ++slot) {
+            if (keys[slot] != kEmpty) {
+                insert(keys[slot], counts[slot]);
+            }
+        }
+    }
+
+    std::vector<quint32> m_keys;
+    std::vector<int> m_counts;
+    std::size_t m_size = 0;
+    int m_shift = 32 - kInitialBits;
+    quint32 m_lastKey = kEmpty;
+    std::size_t m_lastSlot = 0;
+};
+
+/**
+ * 采样网格。
+ * 源图像被划分为 width() × height() 个单元，直接在原图扫描行上读取：
+ * Strided 每个单元取中心像素，Box 对单元内全部像素按 alpha 加权平均。
+ * 每个单元产生一个像素送入量化内核，整个过程不创建任何中间图像。
+ */
+struct SampleGrid {
+    QImage image; // 隐式共享，不复制像素
+    PixelLayout layout = PixelLayout::Argb32;
+    SeedSampling mode = SeedSampling::Strided;
+    std::vector<int> columns; // 单元边界，width() + 1 个
+    std::vector<int> rows;    // 单元边界，height() + 1 个
+
+    int width() const { return static_cast<int>(columns.size()) - 1; }
+    int height() const { return static_cast<int>(rows.size()) - 1; }
+
+    /** 每个网格行需要读取的源像素数，用于划分并行任务。 */
+    qint64 pixelsPerRow() const {
+        return mode == SeedSampling::Box
+            ? static_cast<qint64>(image.width()) * image.height() / std::max(1, height())
+            : width();
+    }
+
+    /** 逐行产生 ARGB32 样本，交给 sink(const QRgb* pixels, int count)。 */
+    template<typename Sink>
+    void scan(int row0, int row1, Sink&& sink) const;
+
+    void accumulate(int row0, int row1, Histogram& histogram) const;
+
+    template<int Bits>
+    void accumulate(int row0, int row1, SparseHistogram<Bits>& histogram) const {
+        scan(row0, row1, [&histogram](const QRgb* pixels, int count) { histogram.add(pixels, count); });
+    }
+};
+
+std::vector<int> cellEdges(int source, int cells) {
+    std::vector<int> edges(cells + 1);
+    for (int i = 0; i <= cells; ++i) {
+        edges[i] = static_cast<int>(static_cast<qint64>(i) * source / cells);
+    }
+    return edges;
+}
+
+template<PixelLayout L, typename Sink>
+void scanGrid(const SampleGrid& grid, int row0, int row1, Sink& sink) {
+    const int width = grid.width();
+
+    // 网格与原图一一对应且无需转换时，把扫描行直接交给内核
+    if (L == PixelLayout::Argb32 && width == grid.image.width() && grid.height() == grid.image.height()) {
+        for (int row = row0; row < row1; ++row) {
+            sink(reinterpret_cast<const QRgb*>(grid.image.constScanLine(row)), width);
+        }
+        return;
+    }
+
+    std::vector<QRgb> samples(width);
+    if (grid.mode != SeedSampling::Box) {
+        for (int row = row0; row < row1; ++row) {
+            const uchar* line = grid.image.constScanLine((grid.rows[row] + grid.rows[row + 1]) / 2);
+            for (int i = 0; i < width; ++i) {
+                samples[i] = fetchPixel<L>(line, (grid.columns[i] + grid.columns[i + 1]) / 2);
+            }
+            sink(samples.data(), width);
+        }
+        return;
+    }
+
+    // Box：按列累加 alpha 加权的颜色和 alpha，逐行读取以保持顺序访存
+    std::vector<quint64> sums(static_cast<size_t>(width) * 4);
+    for (int row = row0; row < row1; ++row) {
+        std::fill(sums.begin(), sums.end(), 0);
+        for (int y = grid.rows[row]; y < grid.rows[row + 1]; ++y) {
+            const uchar* line = grid.image.constScanLine(y);
+            for (int i = 0; i < width; ++i) {
+                quint64* sum = &sums[static_cast<size_t>(i) * 4];
+                for (int x = grid.columns[i]; x < grid.columns[i + 1]; ++x) {
+                    const QRgb pixel = fetchPixel<L>(line, x);
+                    const quint64 alpha = static_cast<quint64>(qAlpha(pixel));
+                    sum[0] += qRed(pixel) * alpha;
+                    sum[1] += qGreen(pixel) * alpha;
+                    sum[2] += qBlue(pixel) * alpha;
+                    sum[3] += alpha;
+                }
+            }
+        }
+        const quint64 cellHeight = static_cast<quint64>(grid.rows[row + 1] - grid.rows[row]);
+        for (int i = 0; i < width; ++i) {
+            const quint64* sum = &sums[static_cast<size_t>(i) * 4];
+            const quint64 area = cellHeight * static_cast<quint64>(grid.columns[i + 1] - grid.columns[i]);
+            if (sum[3] == 0 || area == 0) {
+                samples[i] = 0;
+                continue;
+            }
+            const quint64 half = sum[3] / 2;
+            samples[i] = qRgba(static_cast<int>((sum[0] + half) / sum[3]),
+                               static_cast<int>((sum[1] + half) / sum[3]),
+                               static_cast<int>((sum[2] + half) / sum[3]),
+                               static_cast<int>((sum[3] + area / 2) / area));
+        }
+        sink(samples.data(), width);
+    }
+}
+
+template<typename Sink>
+void SampleGrid::scan(int row0, int row1, Sink&& sink) const {
+    switch (layout) {
+        case PixelLayout::Argb32:
+            scanGrid<PixelLayout::Argb32>(*this, row0, row1, sink);
+            break;
+        case PixelLayout::Argb32Premultiplied:
+            scanGrid<PixelLayout::Argb32Premultiplied>(*this, row0, row1, sink);
+            break;
+        case PixelLayout::Rgba8888:
+            scanGrid<PixelLayout::Rgba8888>(*this, row0, row1, sink);
+            break;
+        case PixelLayout::Rgba8888Premultiplied:
+            scanGrid<PixelLayout::Rgba8888Premultiplied>(*this, row0, row1, sink);
+            break;
+        case PixelLayout::Rgb888:
+            scanGrid<PixelLayout::Rgb888>(*this, row0, row1, sink);
+            break;
+    }
+}
+
+void SampleGrid::accumulate(int row0, int row1, Histogram& histogram) const {
+    static const ScanlineKernel kernel = selectKernel();
+
+    SubHistograms counts;
+    scan(row0, row1, [&counts](const QRgb* pixels, int count) { kernel(pixels, count, counts); });
+    for (int key = 0; key < kHistogramBins; ++key) {
+        int sum = 0;
+        for (int lane = 0; lane < kLanes; ++lane) sum += static_cast<int>(counts.bins[lane][key]);
+        histogram.count[key] += sum;
+    }
+}
+
+/** 网格长边为 maxDimension（不超过原图），0 表示逐像素。 */
+void gridSize(int width, int height, int maxDimension, int& gridWidth, int& gridHeight) {
+    gridWidth = width;
+    gridHeight = height;
+    if (maxDimension > 0 && (width > maxDimension || height > maxDimension)) {
+        if (width > height) {
+            gridWidth = maxDimension;
+            gridHeight = (maxDimension * height) / width;
+        } else {
+            gridHeight = maxDimension;
+            gridWidth = (maxDimension * width) / height;
+        }
+    }
+    gridWidth = std::max(1, gridWidth);
+    gridHeight = std::max(1, gridHeight);
+}
+
+SampleGrid makeGrid(const QImage& image, const SeedExtractionOptions& options) {
+    SampleGrid grid;
+    int gridWidth = 0;
+    int gridHeight = 0;
+
+    if (options.sampling == SeedSampling::Smooth) {
+        // 旧路径：先转换格式并平滑缩放，再逐像素计数
+        int scaledWidth = 0;
+        int scaledHeight = 0;
+        gridSize(image.width(), image.height(), options.maxDimension, scaledWidth, scaledHeight);
+        grid.image = (image.format() == QImage::Format_ARGB32)
+            ? image
+            : image.convertToFormat(QImage::Format_ARGB32);
+        if (scaledWidth != image.width() || scaledHeight != image.height()) {
+            grid.image = grid.image.scaled(scaledWidth, scaledHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        gridWidth = grid.image.width();
+        gridHeight = grid.image.height();
+    } else {
+        grid.mode = options.sampling;
+        if (layoutFor(image.format(), grid.layout)) {
+            grid.image = image;
+        } else {
+            // 不常见的格式只做一次格式转换，仍然不缩放
+            grid.image = image.convertToFormat(QImage::Format_ARGB32);
+        }
+        gridSize(image.width(), image.height(), options.maxDimension, gridWidth, gridHeight);
+    }
+
+    grid.columns = cellEdges(grid.image.width(), gridWidth);
+    grid.rows = cellEdges(grid.image.height(), gridHeight);
+    return grid;
+}
+
+int rowsPerChunk(const SampleGrid& grid) {
+    return static_cast<int>(std::max<qint64>(1, kChunkPixels / std::max<qint64>(1, grid.pixelsPerRow())));
+}
+
+/**
+ * 一次并行量化的共享状态，H 为直方图类型（稠密或稀疏）。
+ * 工作线程按块号从原子计数器领取网格行范围，累加到各自的直方图；
+ * 调用线程也参与领取，因此即使线程池已满、任务迟迟未启动也不会死锁。
+ * 状态由 QSharedPointer 持有，晚启动的任务在调用方返回后访问也是安全的。
+ * 取消后剩余的块只领取、不计算，保证等待方仍能收到全部完成信号。
+ */
+template<typename H>
+struct ParallelJob {
+    SampleGrid grid;
+    CancelCheck canceled;
+    int rowsPerChunk = 0;
+    int chunkCount = 0;
+    std::atomic<int> nextChunk{0};
+    std::vector<H> histograms; // 每个参与者一个
+    QSemaphore finishedChunks;
+
+    void run(int worker) {
+        H& histogram = histograms[worker];
+        for (int chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1)) {
+            if (!canceled || !canceled()) {
+                const int row0 = chunk * rowsPerChunk;
+                grid.accumulate(row0, std::min(row0 + rowsPerChunk, grid.height()), histogram);
+            }
+            finishedChunks.release();
+        }
+    }
+};
+
+template<typename H>
+bool accumulateParallel(SampleGrid grid, H& result, const CancelCheck& canceled) {
+    QThreadPool* pool = QThreadPool::globalInstance();
+
+    auto job = QSharedPointer<ParallelJob<H>>::create();
+    job->rowsPerChunk = rowsPerChunk(grid);
+    job->chunkCount = (grid.height() + job->rowsPerChunk - 1) / job->rowsPerChunk;
+    job->grid = std::move(grid);
+    job->canceled = canceled;
+
+    const int workers = std::max(1, std::min(pool->maxThreadCount(), job->chunkCount));
+    job->histograms.resize(workers);
+
+    for (int worker = 1; worker < workers; ++worker) {
+        pool->start([job, worker]() { job->run(worker); });
+    }
+    job->run(0);
+    job->finishedChunks.acquire(job->chunkCount);
+
+    if (canceled && canceled()) {
+        return false;
+    }
+    for (const H& histogram : job->histograms) {
+        result.merge(histogram);
+    }
+    return true;
+}
+
+/** 采样整幅图像并累加到 result，大图且要求并行时拆分到线程池。 */
+template<typename H>
+bool accumulateImage(const QImage& image, const SeedExtractionOptions& options, H& result,
+                     const CancelCheck& canceled) {
+    if (canceled && canceled()) {
+        return false;
+    }
+
+    SampleGrid grid = makeGrid(image, options);
+    const qint64 work = grid.pixelsPerRow() * grid.height();
+    if (options.parallel && work >= kMinParallelPixels) {
+        return accumulateParallel(std::move(grid), result, canceled);
+    }
+
+    // 串行路径按与并行相同的块大小推进，块之间检查取消
+    const int step = canceled ? rowsPerChunk(grid) : grid.height();
+    for (int row0 = 0; row0 < grid.height(); row0 += step) {
+        if (canceled && canceled()) {
+            return false;
+        }
+        grid.accumulate(row0, std::min(row0 + step, grid.height()), result);
+    }
+    return true;
+}
+
+template<int Bits>
+bool quantizeSparse(const QImage& image, std::vector<ColorBin>& bins,
+                    const SeedExtractionOptions& options, const CancelCheck& canceled) {
+    SparseHistogram<Bits> histogram;
+    if (!accumulateImage(image, options, histogram, canceled)) {
+        return false;
+    }
+    histogram.collect(bins);
+    return true;
+}
+
+struct Lab {
+    double l, a, b;
+};
+
+inline double distance2(const Lab& x, const Lab& y) {
+    const double dl = x.l - y.l;
+    const double da = x.a - y.a;
+    const double db = x.b - y.b;
+    return dl * dl + da * da + db * db;
+}
+
+// 加权 k-means 的最大迭代次数，通常在此之前就已收敛
+constexpr int kMaxClusterIterations = 10;
+// 中心距离（ΔE76）小于该值的聚类视为同一种颜色
+constexpr double kMergeDistance = 16.0;
+
+} // namespace
+
+void Histogram::merge(const Histogram& other) {
+    for (int key = 0; key < kHistogramBins; ++key) {
+        count[key] += other.count[key];
+    }
+}
+
+void Histogram::addTo(std::vector<int>& colorCount) const {
+    for (int key = 0; key < kHistogramBins; ++key) {
+        colorCount[key] += count[key];
+    }
+}
+
+bool quantizeImageColors(const QImage& image, std::vector<int>& colorCount,
+                         const SeedExtractionOptions& options, const CancelCheck& canceled) {
+    //初始化桶
+    if (colorCount.size() != kHistogramBins) {
+        colorCount.assign(kHistogramBins, 0);
+    }
+    if (image.isNull()) {
+        return true;
+    }
+
+    Histogram histogram;
+    if (!accumulateImage(image, options, histogram, canceled)) {
+        return false;
+    }
+    histogram.addTo(colorCount);
+    return true;
+}
+
+bool quantizeImageBins(const QImage& image, std::vector<ColorBin>& bins,
+                       const SeedExtractionOptions& options, const CancelCheck& canceled) {
+    bins.clear();
+    if (image.isNull()) {
+        return true;
+    }
+    switch (binBits(options)) {
+        case 5:
+            return quantizeSparse<5>(image, bins, options, canceled);
+        case 6:
+            return quantizeSparse<6>(image, bins, options, canceled);
+        default: {
+            std::vector<int> colorCount;
+            if (!quantizeImageColors(image, colorCount, options, canceled)) {
+                return false;
+            }
+            for (int key = 0; key < kHistogramBins; ++key) {
+                if (colorCount[key] > 0) {
+                    bins.push_back({static_cast<quint32>(key), colorCount[key]});
+                }
+            }
+            return true;
+        }
+    }
+}
+
+void clusterColors(const std::vector<WeightedColor>& colors, int clusterCount,
+                   std::vector<WeightedColor>& clusters) {
+    clusters.clear();
+    const int count = static_cast<int>(colors.size());
+    if (count == 0 || clusterCount <= 0) {
+        return;
+    }
+
+    std::vector<Lab> points(count);
+    int heaviest = 0;
+    for (int i = 0; i < count; ++i) {
+        const HCTColor& c = colors[i].hct;
+        const double hue = c.hue * M_PI / 180.0;
+        points[i] = {c.tone, c.chroma * std::cos(hue), c.chroma * std::sin(hue)};
+        if (colors[i].weight > colors[heaviest].weight) heaviest = i;
+    }
+
+    // 确定性初始化：先取最重的颜色，之后每次取 权重 × 到最近中心距离² 最大的颜色
+    std::vector<Lab> centroids;
+    centroids.reserve(clusterCount);
+    std::vector<double> nearest(count, std::numeric_limits<double>::max());
+    for (int next = heaviest; next >= 0 && static_cast<int>(centroids.size()) < clusterCount;) {
+        centroids.push_back(points[next]);
+        double best = 0.0;
+        next = -1;
+        for (int i = 0; i < count; ++i) {
+            nearest[i] = std::min(nearest[i], distance2(points[i], centroids.back()));
+            const double score = colors[i].weight * nearest[i];
+            if (score > best) {
+                best = score;
+                next = i;
+            }
+        }
+    }
+
+    const int k = static_cast<int>(centroids.size());
+    std::vector<int> assignment(count, -1);
+    std::vector<double> sums(static_cast<size_t>(k) * 4);
+    for (int iteration = 0; iteration < kMaxClusterIterations; ++iteration) {
+        bool moved = false;
+        for (int i = 0; i < count; ++i) {
+            int best = 0;
+            double bestDistance = distance2(points[i], centroids[0]);
+            for (int c = 1; c < k; ++c) {
+                const double d = distance2(points[i], centroids[c]);
+                if (d < bestDistance) {
+                    bestDistance = d;
+                    best = c;
+                }
+            }
+            if (assignment[i] != best) {
+                assignment[i] = best;
+                moved = true;
+            }
+        }
+        if (!moved) {
+            break; // 分配不再变化，中心已经是当前分配的加权均值
+        }
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        for (int i = 0; i < count; ++i) {
+            double* sum = &sums[static_cast<size_t>(assignment[i]) * 4];
+            const double w = colors[i].weight;
+            sum[0] += points[i].l * w;
+            sum[1] += points[i].a * w;
+            sum[2] += points[i].b * w;
+            sum[3] += w;
+        }
+        for (int c = 0; c < k; ++c) {
+            const double* sum = &sums[static_cast<size_t>(c) * 4];
+            if (sum[3] > 0.0) {
+                centroids[c] = {sum[0] / sum[3], sum[1] / sum[3], sum[2] / sum[3]};
+            }
+        }
+    }
+
+    // 合并中心过近的聚类：同一块带噪声的颜色被拆成的几个子聚类重新合成一个，
+    // 种子取整块颜色的加权均值，而不是其中彩度偏高的一部分
+    std::vector<double> weights(k);
+    for (int c = 0; c < k; ++c) {
+        weights[c] = sums[static_cast<size_t>(c) * 4 + 3];
+    }
+    for (;;) {
+        int first = -1;
+        int second = -1;
+        double closest = kMergeDistance * kMergeDistance;
+        for (int a = 0; a < k; ++a) {
+            for (int b = a + 1; b < k && weights[a] > 0.0; ++b) {
+                const double d = distance2(centroids[a], centroids[b]);
+                if (weights[b] > 0.0 && d < closest) {
+                    closest = d;
+                    first = a;
+                    second = b;
+                }
+            }
+        }
+        if (first < 0) {
+            break;
+        }
+        const double w = weights[first] + weights[second];
+        const Lab& x = centroids[first];
+        const Lab& y = centroids[second];
+        centroids[first] = {(x.l * weights[first] + y.l * weights[second]) / w,
+                            (x.a * weights[first] + y.a * weights[second]) / w,
+                            (x.b * weights[first] + y.b * weights[second]) / w};
+        weights[first] = w;
+        weights[second] = 0.0;
+    }
+
+    for (int c = 0; c < k; ++c) {
+        const double weight = weights[c];
+        if (weight <= 0.0) {
+            continue;
+        }
+        const Lab& centroid = centroids[c];
+        double hue = std::atan2(centroid.b, centroid.a) * 180.0 / M_PI;
+        if (hue < 0.0) hue += 360.0;
+        clusters.push_back({{hue, std::hypot(centroid.a, centroid.b), centroid.l}, weight});
+    }
+}
+
+namespace {
+
+template<PixelLayout L>
+void sampleKeys(const uchar* line, const int* columns, int count, quint16* keys) {
+    for (int i = 0; i < count; ++i) {
+        keys[i] = static_cast<quint16>(pixelKey(fetchPixel<L>(line, columns[i])));
+    }
+}
+
+} // namespace
+
+void sampleBinKeys(const QImage& image, int y, const int* columns, int count, quint16* keys) {
+    PixelLayout layout = PixelLayout::Argb32;
+    if (!layoutFor(image.format(), layout)) {
+        for (int i = 0; i < count; ++i) {
+            keys[i] = static_cast<quint16>(pixelKey(image.pixel(columns[i], y)));
+        }
+        return;
+    }
+    const uchar* line = image.constScanLine(y);
+    switch (layout) {
+        case PixelLayout::Argb32:
+            sampleKeys<PixelLayout::Argb32>(line, columns, count, keys);
+            break;
+        case PixelLayout::Argb32Premultiplied:
+            sampleKeys<PixelLayout::Argb32Premultiplied>(line, columns, count, keys);
+            break;
+        case PixelLayout::Rgba8888:
+            sampleKeys<PixelLayout::Rgba8888>(line, columns, count, keys);
+            break;
+        case PixelLayout::Rgba8888Premultiplied:
+            sampleKeys<PixelLayout::Rgba8888Premultiplied>(line, columns, count, keys);
+            break;
+        case PixelLayout::Rgb888:
+            sampleKeys<PixelLayout::Rgb888>(line, columns, count, keys);
+            break;
+    }
+}
+
+} // namespace Monet
+} // namespace QtWin
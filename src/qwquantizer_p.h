@@ -0,0 +1,151 @@
+#ifndef QWQUANTIZER_P_H
+#define QWQUANTIZER_P_H
+
+// 内部头文件：种子颜色提取使用的直方图量化，不属于公开 API。
+
+#include "QtWin/QWPalette.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace QtWin {
+namespace Monet {
+
+/**
+ * 每通道 Bits 位的桶划分，键为 (r << 2·Bits) | (g << Bits) | b。
+ * 4 位共 4096 个桶，使用稠密直方图和 SIMD 内核；
+ * 5、6 位分别有 32768、262144 个桶，远多于一次采样中出现的颜色，使用稀疏存储。
+ */
+template<int Bits>
+struct BinDepth {
+    static_assert(Bits >= 4 && Bits <= 6, "bin depth must be 4, 5 or 6 bits per channel");
+
+    static constexpr int kBins = 1 << (3 * Bits);
+    static constexpr bool kSparse = Bits > 4;
+
+    static constexpr quint32 key(QRgb pixel) {
+        constexpr quint32 mask = (1u << Bits) - 1;
+        return (((pixel >> (24 - Bits)) & mask) << (2 * Bits))
+             | (((pixel >> (16 - Bits)) & mask) << Bits)
+             | ((pixel >> (8 - Bits)) & mask);
+    }
+};
+
+constexpr int kHistogramBins = BinDepth<4>::kBins; // 默认深度，组合成 12 位键
+
+/** 有效的桶深度，超出 4 ~ 6 的值被截断。 */
+inline int binBits(const SeedExtractionOptions& options) {
+    return std::clamp(options.binBits, 4, 6);
+}
+
+/** bits 位深度下桶的中心颜色（每通道加半步）。 */
+inline RGBColor binCenter(quint32 key, int bits) {
+    const quint32 mask = (1u << bits) - 1;
+    const int shift = 8 - bits;
+    const int half = 1 << (shift - 1);
+    return RGBColor(static_cast<int>(((key >> (2 * bits)) & mask) << shift) + half,
+                    static_cast<int>(((key >> bits) & mask) << shift) + half,
+                    static_cast<int>((key & mask) << shift) + half);
+}
+
+/** 稀疏直方图中的一个非空桶。 */
+struct ColorBin {
+    quint32 key;
+    int count;
+};
+
+/** 带权重的颜色：一个桶（权重为像素数）或一个聚类。 */
+struct WeightedColor {
+    HCTColor hct;
+    double weight;
+};
+
+/**
+ * 单个工作线程私有的直方图。
+ * 按缓存行对齐，多个线程各自累加时不会因为共享缓存行而互相干扰。
+ */
+struct alignas(64) Histogram {
+    int count[kHistogramBins] = {};
+
+    void merge(const Histogram& other);
+    void addTo(std::vector<int>& colorCount) const;
+};
+
+/** 4096 个桶对应的 HCT 颜色与色度过滤结果，首次使用时计算一次。定义在 qwpalette.cpp。 */
+struct BinInfo {
+    HCTColor hct;
+    bool chromatic; // 通过彩度/色调过滤，可参与主评分
+};
+
+const BinInfo* binTable();
+
+/** 评分结果的稳定裕量。 */
+struct ScoreMargin {
+    double margin = 0.0;       // 相邻名次（包括入选的最后一名与落选的第一名）之间的最小分差
+    bool grayFallback = false; // 没有彩色桶，按数量评分
+};
+
+/**
+ * 对（可以是平滑后的、非整数的）直方图评分，选出种子颜色。定义在 qwpalette.cpp。
+ * margin 不为空时返回评分裕量：之后每个桶的评分变化都小于 margin / 2 时，
+ * 入选的颜色及其顺序都不会改变，无需重新评分。
+ */
+void pickTopColors(const std::vector<double>& weights, std::vector<HCTColor>& colorSet,
+                   ScoreMargin* margin = nullptr);
+
+/**
+ * 读取第 y 行上若干列像素所在的桶，alpha < 128 的像素为 kHistogramBins。
+ * 供逐帧增量统计使用，常见格式直接读取扫描行，不做格式转换。
+ */
+void sampleBinKeys(const QImage& image, int y, const int* columns, int count, quint16* keys);
+
+/** 协作式取消检查，返回 true 时尽快停止。会在工作线程中调用，必须线程安全。 */
+using CancelCheck = std::function<bool()>;
+
+/**
+ * 把图像量化到 4096 个桶。
+ * colorCount 大小不为 4096 时会被重置，否则在原有计数上累加。
+ * 每处理完一个扫描行块检查一次 canceled，被取消时返回 false，colorCount 不完整。
+ */
+bool quantizeImageColors(const QImage& image, std::vector<int>& colorCount,
+                         const SeedExtractionOptions& options,
+                         const CancelCheck& canceled = CancelCheck());
+
+/**
+ * 按 options.binBits 的深度量化图像，只输出非空的桶，按键升序排列。
+ * 4 位与 quantizeImageColors 相同；5、6 位使用稀疏直方图，同样支持原地采样与并行。
+ */
+bool quantizeImageBins(const QImage& image, std::vector<ColorBin>& bins,
+                       const SeedExtractionOptions& options,
+                       const CancelCheck& canceled = CancelCheck());
+
+/**
+ * 在 CIELAB 中对颜色做加权 k-means（本库的 HCT 即 CIELCh，a、b 由彩度和色相得到）。
+ * 初始化是确定性的：先取最重的颜色，之后每次取 权重 × 到最近中心距离² 最大的颜色；
+ * 至多迭代固定次数。clusters 按中心输出，权重为成员权重之和，空聚类被丢弃。
+ */
+void clusterColors(const std::vector<WeightedColor>& colors, int clusterCount,
+                   std::vector<WeightedColor>& clusters);
+
+/**
+ * 可取消的 extractSeedColor，被取消时返回 false 且不修改 colorSet。定义在 qwpalette.cpp。
+ * histogram 不为空时用作直方图缓冲区（先清零），批量提取时可以复用而不必每次分配。
+ */
+bool extractSeedColor(const QImage& image, std::vector<HCTColor>& colorSet,
+                      const SeedExtractionOptions& options, const CancelCheck& canceled,
+                      std::vector<int>* histogram = nullptr);
+
+/** 可取消的 extractSeedColorFromFile，解码失败或被取消时返回 false。定义在 qwpalette.cpp。 */
+bool extractSeedColorFromFile(const QString& path, std::vector<HCTColor>& colorSet,
+                              const SeedExtractionOptions& options, const CancelCheck& canceled);
+
+/** 可取消、可复用直方图缓冲区的设备版本，解码失败或被取消时返回 false。定义在 qwpalette.cpp。 */
+bool extractSeedColorFromDevice(QIODevice* device, std::vector<HCTColor>& colorSet,
+                                const SeedExtractionOptions& options, const CancelCheck& canceled,
+                                std::vector<int>* histogram = nullptr);
+
+} // namespace Monet
+} // namespace QtWin
+
+#endif
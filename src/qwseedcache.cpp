@@ -0,0 +1,341 @@
+#include "QtWin/QWSeedCache.h"
+#include "QtWin/QWLogger.h"
+#include "qwquantizer_p.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+QWLOGNAME(qtwinSeedCacheLogger,"qtwin.core.seedcache")
+
+namespace QtWin {
+
+namespace {
+
+// 文件格式：头部 magic + version，之后是连续的记录
+//   key(20 字节 SHA-1) | quint8 颜色数 | 颜色数 × (double hue, chroma, tone)
+constexpr quint32 kMagic = 0x51575343; // "QWSC"
+// 提取结果变化（例如桶中心改用 Float 精度）时也要增加版本，旧缓存整体失效
+constexpr quint16 kVersion = 2;
+constexpr qint64 kHeaderSize = sizeof(quint32) + sizeof(quint16);
+constexpr int kKeySize = 20;
+constexpr int kMaxColors = 255;
+// 磁盘上最多保留的条目数，超出或被覆盖的旧记录过多时重写文件
+constexpr int kMaxDiskEntries = 4096;
+constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_6_0;
+
+void hashOptions(QCryptographicHash& hash, const SeedExtractionOptions& options) {
+    // parallel 不影响结果，不参与缓存键
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(kStreamVersion);
+    stream << qint32(options.maxDimension) << qint32(options.sampling);
+    if (Monet::binBits(options) != 4 || options.quantizer != SeedQuantizer::Histogram) {
+        // 默认量化方式不写入，保持已有缓存键不变
+        stream << qint32(Monet::binBits(options)) << qint32(options.quantizer);
+    }
+    hash.addData(bytes);
+}
+
+void writeRecord(QDataStream& stream, const QWSeedCache::Key& key, const std::vector<HCTColor>& colorSet) {
+    const int count = std::min<int>(static_cast<int>(colorSet.size()), kMaxColors);
+    stream.writeRawData(key.constData(), kKeySize);
+    stream << quint8(count);
+    for (int i = 0; i < count; ++i) {
+        stream << colorSet[i].hue << colorSet[i].chroma << colorSet[i].tone;
+    }
+}
+
+bool readColors(QDataStream& stream, std::vector<HCTColor>& colorSet) {
+    quint8 count = 0;
+    stream >> count;
+    colorSet.resize(count);
+    for (HCTColor& color : colorSet) {
+        stream >> color.hue >> color.chroma >> color.tone;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+QWSeedCache& QWSeedCache::instance() {
+    static QWSeedCache cache;
+    return cache;
+}
+
+QWSeedCache::QWSeedCache() {
+    // QWApplication 启动时已经创建了该目录
+    const QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!dataPath.isEmpty()) {
+        m_filePath = dataPath + "/seedcache.bin";
+    }
+    m_lru.setMaxCost(64);
+}
+
+QWSeedCache::Key QWSeedCache::fileKey(const QString& path, const SeedExtractionOptions& options) {
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        return Key();
+    }
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(kStreamVersion);
+    stream << QStringLiteral("file") << info.absoluteFilePath()
+           << info.lastModified().toMSecsSinceEpoch() << info.size();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(bytes);
+    hashOptions(hash, options);
+    return hash.result();
+}
+
+QWSeedCache::Key QWSeedCache::contentKey(const QByteArray& data, const SeedExtractionOptions& options) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayLiteral("content"));
+    hash.addData(data);
+    hashOptions(hash, options);
+    return hash.result();
+}
+
+bool QWSeedCache::extractFromFile(const QString& path, std::vector<HCTColor>& colorSet,
+                                  const SeedExtractionOptions& options) {
+    const Key key = fileKey(path, options);
+    if (!key.isEmpty() && lookup(key, colorSet)) {
+        return true;
+    }
+    if (!extractSeedColorFromFile(path, colorSet, options)) {
+        return false;
+    }
+    if (!key.isEmpty()) {
+        insert(key, colorSet);
+    }
+    return true;
+}
+
+bool QWSeedCache::extractFromDevice(QIODevice* device, std::vector<HCTColor>& colorSet,
+                                    const SeedExtractionOptions& options) {
+    QByteArray data = device->readAll();
+    const Key key = contentKey(data, options);
+    if (lookup(key, colorSet)) {
+        return true;
+    }
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    if (!extractSeedColor(&buffer, colorSet, options)) {
+        return false;
+    }
+    insert(key, colorSet);
+    return true;
+}
+
+bool QWSeedCache::lookup(const Key& key, std::vector<HCTColor>& colorSet) {
+    const QMutexLocker locker(&m_mutex);
+    if (const std::vector<HCTColor>* cached = m_lru.object(key)) {
+        colorSet = *cached;
+        return true;
+    }
+    if (!openFile()) {
+        return false;
+    }
+    const auto it = m_index.constFind(key);
+    if (it == m_index.constEnd() || !readRecord(it.value(), colorSet)) {
+        return false;
+    }
+    m_lru.insert(key, new std::vector<HCTColor>(colorSet));
+    return true;
+}
+
+void QWSeedCache::insert(const Key& key, const std::vector<HCTColor>& colorSet) {
+    const QMutexLocker locker(&m_mutex);
+    m_lru.insert(key, new std::vector<HCTColor>(colorSet));
+    if (!openFile()) {
+        return;
+    }
+
+    const qint64 offset = m_file.size();
+    m_file.seek(offset);
+    QDataStream stream(&m_file);
+    stream.setVersion(kStreamVersion);
+    writeRecord(stream, key, colorSet);
+    m_file.flush();
+    if (stream.status() != QDataStream::Ok) {
+        qwLogger(LogLevel::Warning,qtwinSeedCacheLogger)<<"Failed to write seed cache:"<<m_file.errorString();
+        return;
+    }
+    m_index.insert(key, offset);
+    ++m_recordCount;
+
+    if ((m_index.size() > kMaxDiskEntries || m_recordCount > 2 * m_index.size() + 64)
+        && m_recordCount >= m_compactRetryAt) {
+        compact();
+    }
+}
+
+void QWSeedCache::setFilePath(const QString& filePath) {
+    const QMutexLocker locker(&m_mutex);
+    m_file.close();
+    m_opened = false;
+    m_index.clear();
+    m_recordCount = 0;
+    m_compactRetryAt = 0;
+    m_lru.clear();
+    m_filePath = filePath;
+}
+
+QString QWSeedCache::filePath() const {
+    const QMutexLocker locker(&m_mutex);
+    return m_filePath;
+}
+
+void QWSeedCache::setMemoryCapacity(int capacity) {
+    const QMutexLocker locker(&m_mutex);
+    m_lru.setMaxCost(std::max(1, capacity));
+}
+
+int QWSeedCache::memoryCapacity() const {
+    const QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_lru.maxCost());
+}
+
+int QWSeedCache::size() const {
+    const QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_index.size());
+}
+
+void QWSeedCache::clear() {
+    const QMutexLocker locker(&m_mutex);
+    m_lru.clear();
+    m_index.clear();
+    m_recordCount = 0;
+    m_compactRetryAt = 0;
+    m_file.close();
+    m_opened = false;
+    if (!m_filePath.isEmpty()) {
+        QFile::remove(m_filePath);
+    }
+}
+
+bool QWSeedCache::openFile() {
+    // 调用方必须持有 m_mutex。首次访问时打开文件并扫描一遍建立 键 -> 偏移 的索引，颜色不常驻内存。
+    if (m_opened) {
+        return m_file.isOpen();
+    }
+    m_opened = true;
+    if (m_filePath.isEmpty()) {
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qwLogger(LogLevel::Warning,qtwinSeedCacheLogger)<<"Could not open seed cache:"<<m_filePath;
+        return false;
+    }
+
+    QDataStream stream(&m_file);
+    stream.setVersion(kStreamVersion);
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != kMagic || version != kVersion) {
+        // 空文件、损坏或旧版本：重新开始
+        m_file.resize(0);
+        m_file.seek(0);
+        stream.resetStatus();
+        stream << kMagic << kVersion;
+        m_file.flush();
+        return true;
+    }
+
+    qint64 offset = kHeaderSize;
+    std::vector<HCTColor> colors;
+    while (!m_file.atEnd()) {
+        Key key(kKeySize, Qt::Uninitialized);
+        if (stream.readRawData(key.data(), kKeySize) != kKeySize || !readColors(stream, colors)) {
+            break;
+        }
+        m_index.insert(key, offset); // 同一个键出现多次时保留最新的记录
+        ++m_recordCount;
+        offset = m_file.pos();
+    }
+    if (offset != m_file.size()) {
+        // 上次写入中断留下的不完整记录
+        m_file.resize(offset);
+    }
+    return true;
+}
+
+bool QWSeedCache::readRecord(qint64 offset, std::vector<HCTColor>& colorSet) {
+    if (!m_file.seek(offset + kKeySize)) {
+        return false;
+    }
+    QDataStream stream(&m_file);
+    stream.setVersion(kStreamVersion);
+    return readColors(stream, colorSet);
+}
+
+void QWSeedCache::compact() {
+    // 调用方必须持有 m_mutex。按写入顺序保留最新的 kMaxDiskEntries / 2 条记录。
+    QList<QPair<qint64, Key>> live;
+    live.reserve(m_index.size());
+    for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        live.append({it.value(), it.key()});
+    }
+    std::sort(live.begin(), live.end());
+    if (live.size() > kMaxDiskEntries / 2) {
+        live.erase(live.begin(), live.end() - kMaxDiskEntries / 2);
+    }
+
+    QSaveFile out(m_filePath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qwLogger(LogLevel::Warning,qtwinSeedCacheLogger)<<"Failed to compact seed cache:"<<m_filePath;
+        m_compactRetryAt = m_recordCount * 2;
+        return;
+    }
+    QDataStream stream(&out);
+    stream.setVersion(kStreamVersion);
+    stream << kMagic << kVersion;
+    QHash<Key, qint64> index;
+    std::vector<HCTColor> colors;
+    for (const auto& record : live) {
+        if (!readRecord(record.first, colors)) {
+            continue;
+        }
+        index.insert(record.second, out.pos());
+        writeRecord(stream, record.second, colors);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        out.cancelWriting();
+    }
+
+    // Windows 上无法替换仍被打开的文件：先关闭，无论提交是否成功都重新打开
+    m_file.close();
+    const bool committed = out.commit();
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qwLogger(LogLevel::Warning,qtwinSeedCacheLogger)<<"Could not reopen seed cache:"<<m_filePath;
+        m_index.clear();
+        m_recordCount = 0;
+        return;
+    }
+    m_file.seek(m_file.size());
+
+    if (!committed) {
+        // 保留原文件与索引；等记录数翻倍后再重试，而不是每次写入都重写一遍
+        qwLogger(LogLevel::Warning,qtwinSeedCacheLogger)<<"Failed to compact seed cache:"<<m_filePath;
+        m_compactRetryAt = m_recordCount * 2;
+        return;
+    }
+    m_index = index;
+    m_recordCount = index.size();
+    m_compactRetryAt = 0;
+}
+
+} // namespace QtWin
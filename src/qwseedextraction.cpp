@@ -0,0 +1,109 @@
+#include "QtWin/QWPalette.h"
+#include "qwquantizer_p.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPromise>
+#include <QThreadPool>
+
+#include <memory>
+
+namespace QtWin {
+
+namespace {
+
+using SeedColors = std::vector<HCTColor>;
+using SeedWork = std::function<bool(SeedColors&, const Monet::CancelCheck&)>;
+
+/**
+ * 异步提取的调度器。
+ * 使用独立的线程池，不与 QThreadPool::globalInstance() 上的并行直方图任务争抢线程；
+ * 每个通道只记录最新的、尚未完成的请求，新请求到来时取消同一通道上的旧请求；
+ * 请求完成时移除自己的记录，按文件路径等逐项使用通道时不会无限累积。
+ */
+class AsyncSeedExtraction {
+public:
+    static AsyncSeedExtraction& instance() {
+        static AsyncSeedExtraction extraction;
+        return extraction;
+    }
+
+    QFuture<SeedColors> submit(const QString& channel, SeedWork work) {
+        auto promise = std::make_shared<QPromise<SeedColors>>();
+        QFuture<SeedColors> future = promise->future();
+        promise->start();
+
+        quint64 id = 0;
+        {
+            const QMutexLocker locker(&m_mutex);
+            id = ++m_nextId;
+            auto it = m_latest.find(channel);
+            if (it != m_latest.end()) {
+                it->future.cancel(); // 旧请求在下一个扫描行块之前停止
+                *it = Request{future, id};
+            } else {
+                m_latest.insert(channel, Request{future, id});
+            }
+        }
+
+        m_pool.start([this, channel, id, promise, work = std::move(work)]() {
+            const Monet::CancelCheck canceled = [promise]() { return promise->isCanceled(); };
+            SeedColors colors;
+            if (!canceled() && work(colors, canceled) && !canceled()) {
+                promise->addResult(std::move(colors));
+            }
+            promise->finish();
+            finished(channel, id);
+        });
+        return future;
+    }
+
+private:
+    AsyncSeedExtraction() {
+        m_pool.setObjectName(QStringLiteral("QtWinSeedExtraction"));
+        m_pool.setMaxThreadCount(2);
+    }
+    Q_DISABLE_COPY(AsyncSeedExtraction)
+
+    struct Request {
+        QFuture<SeedColors> future;
+        quint64 id;
+    };
+
+    /** 请求完成后，如果它仍是该通道的最新请求，移除记录。 */
+    void finished(const QString& channel, quint64 id) {
+        const QMutexLocker locker(&m_mutex);
+        auto it = m_latest.find(channel);
+        if (it != m_latest.end() && it->id == id) {
+            m_latest.erase(it);
+        }
+    }
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QHash<QString, Request> m_latest;
+    quint64 m_nextId = 0;
+};
+
+} // namespace
+
+QFuture<std::vector<HCTColor>> extractSeedColorAsync(const QImage& image,
+                                                    const SeedExtractionOptions& options,
+                                                    const QString& channel) {
+    return AsyncSeedExtraction::instance().submit(channel,
+        [image, options](SeedColors& colors, const Monet::CancelCheck& canceled) {
+            return Monet::extractSeedColor(image, colors, options, canceled);
+        });
+}
+
+QFuture<std::vector<HCTColor>> extractSeedColorFromFileAsync(const QString& path,
+                                                            const SeedExtractionOptions& options,
+                                                            const QString& channel) {
+    return AsyncSeedExtraction::instance().submit(channel,
+        [path, options](SeedColors& colors, const Monet::CancelCheck& canceled) {
+            return Monet::extractSeedColorFromFile(path, colors, options, canceled);
+        });
+}
+
+} // namespace QtWin
@@ -0,0 +1,262 @@
+#include "QtWin/QWSeedExtractor.h"
+#include "QtWin/QWSeedCache.h"
+#include "qwquantizer_p.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <deque>
+
+namespace QtWin {
+
+/**
+ * 直方图缓冲区池。
+ * 每个工作线程在开始时取出一个缓冲区，处理完全部图片后归还；
+ * 缓冲区随提取器存活，多次 extractAll 之间也会复用。
+ */
+class QWSeedExtractor::HistogramPool {
+public:
+    std::vector<int>* acquire() {
+        const QMutexLocker locker(&m_mutex);
+        if (m_free.empty()) {
+            m_buffers.push_back(std::make_unique<std::vector<int>>(Monet::kHistogramBins));
+            return m_buffers.back().get();
+        }
+        std::vector<int>* buffer = m_free.back();
+        m_free.pop_back();
+        return buffer;
+    }
+
+    void release(std::vector<int>* buffer) {
+        const QMutexLocker locker(&m_mutex);
+        m_free.push_back(buffer);
+    }
+
+private:
+    QMutex m_mutex;
+    std::vector<std::unique_ptr<std::vector<int>>> m_buffers;
+    std::vector<std::vector<int>*> m_free;
+};
+
+namespace {
+
+/** 已读取、等待解码的图片。 */
+struct PendingImage {
+    int index = -1;
+    QString path;
+    QWSeedCache::Key key;
+    QByteArray data;
+};
+
+/**
+ * 读取端与工作线程之间的有界队列。
+ * 队列满时 push 阻塞，读取端因此不会领先解码太多，内存占用有上限。
+ */
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity) : m_capacity(std::max(1, capacity)) {}
+
+    bool push(PendingImage&& item, const Monet::CancelCheck& canceled) {
+        QMutexLocker locker(&m_mutex);
+        while (static_cast<int>(m_items.size()) >= m_capacity) {
+            if (canceled()) {
+                return false;
+            }
+            m_notFull.wait(&m_mutex, 50); // 定期醒来检查取消
+        }
+        m_items.push_back(std::move(item));
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    bool pop(PendingImage& item) {
+        QMutexLocker locker(&m_mutex);
+        while (m_items.empty()) {
+            if (m_closed) {
+                return false;
+            }
+            m_notEmpty.wait(&m_mutex);
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    void close() {
+        const QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notFull;
+    QWaitCondition m_notEmpty;
+    std::deque<PendingImage> m_items;
+    const int m_capacity;
+    bool m_closed = false;
+};
+
+/** 串行化回调并统计进度。 */
+class Delivery {
+public:
+    Delivery(const QWSeedExtractor::ResultCallback& onResult,
+             const QWSeedExtractor::ProgressCallback& onProgress, int total)
+        : m_onResult(onResult), m_onProgress(onProgress), m_total(total) {}
+
+    void deliver(const QWSeedExtractor::Result& result) {
+        const QMutexLocker locker(&m_mutex);
+        ++m_finished;
+        if (result.ok) {
+            ++m_succeeded;
+        }
+        if (m_onResult) {
+            m_onResult(result);
+        }
+        if (m_onProgress) {
+            m_onProgress(m_finished, m_total);
+        }
+    }
+
+    int succeeded() const {
+        const QMutexLocker locker(&m_mutex);
+        return m_succeeded;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    const QWSeedExtractor::ResultCallback& m_onResult;
+    const QWSeedExtractor::ProgressCallback& m_onProgress;
+    const int m_total;
+    int m_finished = 0;
+    int m_succeeded = 0;
+};
+
+} // namespace
+
+QWSeedExtractor::QWSeedExtractor(const SeedExtractionOptions& options)
+    : m_options(options),
+      m_maxWorkers(std::max(1, QThread::idealThreadCount())),
+      m_histograms(std::make_unique<HistogramPool>()) {
+    m_pool.setObjectName(QStringLiteral("QtWinSeedExtractor"));
+}
+
+QWSeedExtractor::~QWSeedExtractor() {
+    cancel();
+    m_pool.waitForDone();
+}
+
+void QWSeedExtractor::setMaxWorkers(int workers) {
+    m_maxWorkers = std::max(1, workers);
+}
+
+int QWSeedExtractor::maxWorkers() const {
+    return m_maxWorkers;
+}
+
+void QWSeedExtractor::setQueueDepth(int depth) {
+    m_queueDepth = std::max(0, depth);
+}
+
+int QWSeedExtractor::queueDepth() const {
+    return m_queueDepth > 0 ? m_queueDepth : 2 * m_maxWorkers;
+}
+
+void QWSeedExtractor::setUseCache(bool useCache) {
+    m_useCache = useCache;
+}
+
+bool QWSeedExtractor::useCache() const {
+    return m_useCache;
+}
+
+void QWSeedExtractor::cancel() {
+    // 只取消当前（或最近一次）运行，之后开始的 extractAll 不受影响
+    m_canceledRun.store(m_run.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+int QWSeedExtractor::extractAll(const QStringList& paths, const ResultCallback& onResult,
+                                const ProgressCallback& onProgress) {
+    // 每次运行取一个新的编号，上一次运行结束后才到达的 cancel() 不会影响这一次
+    const quint64 run = m_run.fetch_add(1, std::memory_order_relaxed) + 1;
+    const Monet::CancelCheck canceled = [this, run]() {
+        return m_canceledRun.load(std::memory_order_relaxed) >= run;
+    };
+
+    const int workers = std::min<int>(m_maxWorkers, std::max<int>(1, static_cast<int>(paths.size())));
+    m_pool.setMaxThreadCount(workers);
+    BoundedQueue queue(queueDepth());
+    Delivery delivery(onResult, onProgress, static_cast<int>(paths.size()));
+
+    // 解码与直方图阶段：每个工作线程持有一个池中的直方图缓冲区
+    for (int worker = 0; worker < workers; ++worker) {
+        m_pool.start([this, &queue, &delivery, &canceled]() {
+            std::vector<int>* histogram = m_histograms->acquire();
+            PendingImage item;
+            while (queue.pop(item)) {
+                if (canceled()) {
+                    continue; // 取走剩余数据，让读取端尽快退出
+                }
+                Result result;
+                result.index = item.index;
+                result.path = item.path;
+                QBuffer buffer(&item.data);
+                buffer.open(QIODevice::ReadOnly);
+                result.ok = Monet::extractSeedColorFromDevice(&buffer, result.colors, m_options, canceled, histogram);
+                if (canceled()) {
+                    continue;
+                }
+                if (result.ok && !item.key.isEmpty()) {
+                    QWSeedCache::instance().insert(item.key, result.colors);
+                }
+                delivery.deliver(result);
+            }
+            m_histograms->release(histogram);
+        });
+    }
+
+    // 读取阶段：在调用线程中顺序读取，IO 与解码重叠进行
+    for (int index = 0; index < paths.size() && !canceled(); ++index) {
+        PendingImage item;
+        item.index = index;
+        item.path = paths.at(index);
+
+        if (m_useCache) {
+            item.key = QWSeedCache::fileKey(item.path, m_options);
+            Result result;
+            if (!item.key.isEmpty() && QWSeedCache::instance().lookup(item.key, result.colors)) {
+                result.index = index;
+                result.path = item.path;
+                result.ok = true;
+                result.cached = true;
+                delivery.deliver(result);
+                continue;
+            }
+        }
+
+        QFile file(item.path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            Result result;
+            result.index = index;
+            result.path = item.path;
+            delivery.deliver(result);
+            continue;
+        }
+        item.data = file.readAll();
+        if (!queue.push(std::move(item), canceled)) {
+            break;
+        }
+    }
+
+    queue.close();
+    m_pool.waitForDone();
+    return delivery.succeeded();
+}
+
+} // namespace QtWin
@@ -0,0 +1,217 @@
+#include "QtWin/QWSeedTracker.h"
+#include "qwquantizer_p.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace QtWin {
+
+namespace {
+
+// 透明像素计入的哑桶
+constexpr int kTransparentBin = Monet::kHistogramBins;
+
+bool sameColors(const std::vector<HCTColor>& a, const std::vector<HCTColor>& b) {
+    // 颜色都取自固定的桶表，可以精确比较
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const HCTColor& x, const HCTColor& y) {
+        return x.hue == y.hue && x.chroma == y.chroma && x.tone == y.tone;
+    });
+}
+
+/** 在 [0, source) 上均匀放置 count 个采样坐标，取每段的中心。 */
+std::vector<int> samplePositions(int source, int count) {
+    std::vector<int> positions(count);
+    for (int i = 0; i < count; ++i) {
+        positions[i] = static_cast<int>((2 * static_cast<qint64>(i) + 1) * source / (2 * count));
+    }
+    return positions;
+}
+
+} // namespace
+
+QWSeedTracker::QWSeedTracker() = default;
+
+void QWSeedTracker::setSampleCount(int count) {
+    m_sampleCount = std::max(1, count);
+    reset();
+}
+
+int QWSeedTracker::sampleCount() const {
+    return m_sampleCount;
+}
+
+void QWSeedTracker::setRefreshInterval(int frames) {
+    m_refreshInterval = std::max(1, frames);
+    m_phase = 0;
+}
+
+int QWSeedTracker::refreshInterval() const {
+    return m_refreshInterval;
+}
+
+void QWSeedTracker::setSmoothing(double factor) {
+    m_smoothing = std::clamp(factor, 0.01, 1.0);
+}
+
+double QWSeedTracker::smoothing() const {
+    return m_smoothing;
+}
+
+bool QWSeedTracker::update(const QImage& frame) {
+    if (frame.isNull()) {
+        return false;
+    }
+    ++m_frames;
+    if (frame.size() != m_frameSize) {
+        return restart(frame);
+    }
+
+    // 按行轮流读取，每帧覆盖整幅画面的 1/m_refreshInterval
+    bool sampled = false;
+    const int columns = static_cast<int>(m_columns.size());
+    for (int row = m_phase; row < static_cast<int>(m_rows.size()); row += m_refreshInterval) {
+        sampled = refreshRow(frame, row, 0, columns) || sampled;
+    }
+    m_phase = (m_phase + 1) % m_refreshInterval;
+    return integrate(sampled);
+}
+
+bool QWSeedTracker::update(const QImage& frame, const QRect& changed) {
+    if (frame.isNull()) {
+        return false;
+    }
+    ++m_frames;
+    if (frame.size() != m_frameSize) {
+        return restart(frame);
+    }
+
+    const int first = static_cast<int>(std::lower_bound(m_columns.begin(), m_columns.end(), changed.left()) - m_columns.begin());
+    const int last = static_cast<int>(std::upper_bound(m_columns.begin(), m_columns.end(), changed.right()) - m_columns.begin());
+    const int top = static_cast<int>(std::lower_bound(m_rows.begin(), m_rows.end(), changed.top()) - m_rows.begin());
+    const int bottom = static_cast<int>(std::upper_bound(m_rows.begin(), m_rows.end(), changed.bottom()) - m_rows.begin());
+    bool sampled = false;
+    for (int row = top; row < bottom && first < last; ++row) {
+        sampled = refreshRow(frame, row, first, last) || sampled;
+    }
+    return integrate(sampled);
+}
+
+const std::vector<HCTColor>& QWSeedTracker::colors() const {
+    return m_colors;
+}
+
+void QWSeedTracker::reset() {
+    m_frameSize = QSize();
+    m_columns.clear();
+    m_rows.clear();
+    m_keys.clear();
+    m_colors.clear();
+    m_phase = 0;
+}
+
+int QWSeedTracker::frameCount() const {
+    return m_frames;
+}
+
+int QWSeedTracker::scoringCount() const {
+    return m_scorings;
+}
+
+bool QWSeedTracker::restart(const QImage& frame) {
+    // 按画面比例把采样点排成网格，读取全部采样点，不做平滑
+    m_frameSize = frame.size();
+    const double aspect = static_cast<double>(frame.width()) / frame.height();
+    const int columns = std::clamp(static_cast<int>(std::lround(std::sqrt(m_sampleCount * aspect))), 1, frame.width());
+    const int rows = std::clamp(m_sampleCount / columns, 1, frame.height());
+    m_columns = samplePositions(frame.width(), columns);
+    m_rows = samplePositions(frame.height(), rows);
+    m_keys.assign(static_cast<size_t>(columns) * rows, static_cast<quint16>(kTransparentBin));
+    m_scratch.resize(columns);
+    m_counts.assign(Monet::kHistogramBins + 1, 0);
+    m_counts[kTransparentBin] = columns * rows;
+    m_phase = 0;
+
+    for (int row = 0; row < rows; ++row) {
+        refreshRow(frame, row, 0, columns);
+    }
+    const int opaque = columns * rows - m_counts[kTransparentBin];
+    const double scale = opaque > 0 ? 1.0 / opaque : 0.0;
+    m_smoothed.resize(Monet::kHistogramBins);
+    for (int key = 0; key < Monet::kHistogramBins; ++key) {
+        m_smoothed[key] = m_counts[key] * scale;
+    }
+    m_settled = true;
+    return rescore();
+}
+
+bool QWSeedTracker::refreshRow(const QImage& frame, int row, int first, int last) {
+    // 与该行采样点上一次的读数比较，只调整发生变化的桶
+    Monet::sampleBinKeys(frame, m_rows[row], m_columns.data() + first, last - first, m_scratch.data());
+    quint16* keys = m_keys.data() + static_cast<size_t>(row) * m_columns.size() + first;
+    bool changed = false;
+    for (int i = 0; i < last - first; ++i) {
+        if (keys[i] != m_scratch[i]) {
+            --m_counts[keys[i]];
+            ++m_counts[m_scratch[i]];
+            keys[i] = m_scratch[i];
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool QWSeedTracker::integrate(bool sampled) {
+    // 采样没有变化且平滑已经收敛：直方图不会再变，什么都不用做
+    if (!sampled && m_settled) {
+        return false;
+    }
+
+    const int samples = static_cast<int>(m_keys.size());
+    const int opaque = samples - m_counts[kTransparentBin];
+    const double scale = opaque > 0 ? 1.0 / opaque : 0.0;
+    // 与目标相差不到半个采样点时直接取目标，避免指数衰减留下永远不为零的微小权重
+    const double negligible = 0.5 / samples;
+    const Monet::BinInfo* bins = Monet::binTable();
+
+    double drift = 0.0; // 各桶评分相对上次评分的最大变化
+    bool settled = true;
+    bool chromaticAppeared = false;
+    for (int key = 0; key < Monet::kHistogramBins; ++key) {
+        const double target = m_counts[key] * scale;
+        double value = m_smoothed[key] + m_smoothing * (target - m_smoothed[key]);
+        if (std::abs(value - target) < negligible) {
+            value = target;
+        } else {
+            settled = false;
+        }
+        m_smoothed[key] = value;
+
+        // 灰阶兜底时按数量评分，否则只有彩色桶参与、评分为 比例 × 彩度
+        const double weight = m_grayFallback ? 1.0 : (bins[key].chromatic ? bins[key].hct.chroma : 0.0);
+        drift = std::max(drift, std::abs(value - m_scored[key]) * weight);
+        chromaticAppeared = chromaticAppeared || (m_grayFallback && bins[key].chromatic && value > 0.0);
+    }
+    m_settled = settled;
+
+    // 每个桶的评分变化都小于裕量的一半时，任意两个名次都不可能交换
+    if (!chromaticAppeared && 2.0 * drift < m_margin) {
+        return false;
+    }
+    return rescore();
+}
+
+bool QWSeedTracker::rescore() {
+    std::vector<HCTColor> colors;
+    Monet::ScoreMargin margin;
+    Monet::pickTopColors(m_smoothed, colors, &margin);
+    ++m_scorings;
+    m_scored = m_smoothed;
+    m_margin = margin.margin;
+    m_grayFallback = margin.grayFallback;
+
+    const bool changed = !sameColors(colors, m_colors);
+    m_colors.swap(colors);
+    return changed;
+}
+
+} // namespace QtWin
@@ -22,8 +22,9 @@ QWSettings::QWSettings(QObject* parent, const QString& configFilePath)
         finalPath = configDir + "/settings.conf";
     }
 
-    // 创建 QSettings 实例，强制使用 INI 文件格式
-    m_settings.reset(new QSettings(finalPath, QSettings::IniFormat));
+    // 创建 QSettings 实例，强制使用 INI 文件格式。
+    // 作为子对象随本对象一起 moveToThread；析构时 m_settings 先于 QObject 释放，会从子对象列表中移除
+    m_settings.reset(new QSettings(finalPath, QSettings::IniFormat, this));
 }
 
 QString QWSettings::filePath() const {
@@ -69,7 +70,7 @@ void QWSettings::setFilePath(const QString& filePath) {
     }
 
     // Create new QSettings instance with the new path
-    m_settings.reset(new QSettings(finalPath, QSettings::IniFormat));
+    m_settings.reset(new QSettings(finalPath, QSettings::IniFormat, this));
 }
 
 } // namespace QtWin
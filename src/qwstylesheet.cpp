@@ -0,0 +1,279 @@
+#include "QtWin/QWStyleSheet.h"
+#include "QtWin/QWLogger.h"
+
+#include <QCache>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <vector>
+
+QWLOGNAME(qtwinStyleSheetLogger,"qtwin.core.stylesheet")
+
+namespace QtWin {
+
+namespace {
+
+/** 渲染缓存的键：主题配置 + 深浅模式。 */
+struct State {
+    QWPaletteCache::Key key;
+    bool dark;
+
+    bool operator==(const State& other) const {
+        return key == other.key && dark == other.dark;
+    }
+};
+
+size_t qHash(const State& state, size_t seed = 0) noexcept {
+    return qHashMulti(seed, state.key, state.dark);
+}
+
+State makeState(const QColor& seed, int lightTone, int darkTone, bool dark) {
+    return State{QWPaletteCache::Key{seed.rgb(), lightTone, darkTone, GamutMapping::Clip}, dark};
+}
+
+int roleFromName(QStringView name) {
+    static const struct {
+        const char* name;
+        QWPalette::QWColor role;
+    } kRoles[] = {
+        {"mainColor", QWPalette::mainColor},
+        {"subColor", QWPalette::subColor},
+        {"neutralColor", QWPalette::neutralColor},
+        {"neutralAccent", QWPalette::neutralAccent},
+        {"accentColor", QWPalette::accentColor}
+    };
+    for (const auto& entry : kRoles) {
+        if (name == QLatin1StringView(entry.name)) {
+            return entry.role;
+        }
+    }
+    return -1;
+}
+
+bool isAsciiLetter(QChar c) {
+    return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z');
+}
+
+/** 以 #rrggbb 追加颜色，不经过 QColor::name() 的临时字符串。 */
+void appendColor(QString& out, QRgb rgb) {
+    static const char kHex[] = "0123456789abcdef";
+    const QChar digits[7] = {
+        u'#',
+        QLatin1Char(kHex[qRed(rgb) >> 4]), QLatin1Char(kHex[qRed(rgb) & 15]),
+        QLatin1Char(kHex[qGreen(rgb) >> 4]), QLatin1Char(kHex[qGreen(rgb) & 15]),
+        QLatin1Char(kHex[qBlue(rgb) >> 4]), QLatin1Char(kHex[qBlue(rgb) & 15])
+    };
+    out.append(digits, 7);
+}
+
+} // namespace
+
+struct QWStyleSheet::Data {
+    // 文本片段（role < 0）或占位符；tone < 0 表示使用当前模式的默认色调
+    struct Token {
+        QString text;
+        int role = -1;
+        int tone = -1;
+    };
+
+    QString source;
+    std::vector<Token> tokens;
+    int placeholders = 0;
+    qsizetype literalLength = 0;
+
+    QMutex mutex; // 保护 rendered 与 pending
+    QCache<State, QString> rendered;
+    QSet<State> pending; // 正在后台渲染的状态
+
+    void parse();
+    QString render(const QWToneTable& tones, int defaultTone) const;
+    void store(const State& state, const QString& sheet);
+};
+
+void QWStyleSheet::Data::parse() {
+    const QStringView view(source);
+    const qsizetype size = view.size();
+    QString literal;
+    QStringList unknown;
+
+    const auto flush = [&]() {
+        if (!literal.isEmpty()) {
+            literalLength += literal.size();
+            tokens.push_back(Token{literal, -1, -1});
+            literal.clear();
+        }
+    };
+
+    qsizetype pos = 0;
+    while (pos < size) {
+        const qsizetype at = view.indexOf(u'@', pos);
+        if (at < 0) {
+            literal += view.mid(pos);
+            break;
+        }
+        literal += view.mid(pos, at - pos);
+        if (at + 1 < size && view[at + 1] == u'@') {
+            literal += u'@'; // @@ 转义
+            pos = at + 2;
+            continue;
+        }
+
+        qsizetype end = at + 1;
+        while (end < size && isAsciiLetter(view[end])) {
+            ++end;
+        }
+        const QStringView name = view.mid(at + 1, end - at - 1);
+        const int role = roleFromName(name);
+        if (role < 0) {
+            // 不是色彩角色：按原文保留
+            if (!name.isEmpty()) {
+                unknown << name.toString();
+            }
+            literal += view.mid(at, end - at);
+            pos = end;
+            continue;
+        }
+
+        int tone = -1;
+        if (end + 1 < size && view[end] == u'.' && view[end + 1].isDigit()) {
+            tone = 0;
+            ++end;
+            for (int digits = 0; end < size && view[end].isDigit() && digits < 3; ++end, ++digits) {
+                tone = tone * 10 + view[end].digitValue();
+            }
+            tone = std::min(tone, 100);
+        }
+
+        flush();
+        tokens.push_back(Token{QString(), role, tone});
+        ++placeholders;
+        pos = end;
+    }
+    flush();
+
+    if (!unknown.isEmpty()) {
+        qwLogger(LogLevel::Warning,qtwinStyleSheetLogger) << "Unknown color roles kept verbatim:" << unknown.join(", ");
+    }
+}
+
+QString QWStyleSheet::Data::render(const QWToneTable& tones, int defaultTone) const {
+    QString out;
+    out.reserve(literalLength + placeholders * 7);
+    for (const Token& token : tokens) {
+        if (token.role < 0) {
+            out += token.text;
+        } else {
+            appendColor(out, tones.rgb(static_cast<QWPalette::QWColor>(token.role),
+                                       token.tone < 0 ? defaultTone : token.tone));
+        }
+    }
+    return out;
+}
+
+void QWStyleSheet::Data::store(const State& state, const QString& sheet) {
+    const QMutexLocker locker(&mutex);
+    pending.remove(state);
+    if (!rendered.contains(state)) {
+        rendered.insert(state, new QString(sheet));
+    }
+}
+
+QWStyleSheet::QWStyleSheet() = default;
+
+QWStyleSheet::QWStyleSheet(const QString& source)
+    : d(QSharedPointer<Data>::create())
+{
+    d->source = source;
+    d->rendered.setMaxCost(8);
+    d->parse();
+}
+
+bool QWStyleSheet::isNull() const {
+    return !d;
+}
+
+QString QWStyleSheet::source() const {
+    return d ? d->source : QString();
+}
+
+int QWStyleSheet::placeholderCount() const {
+    return d ? d->placeholders : 0;
+}
+
+QString QWStyleSheet::render(const QWToneTable& tones, int defaultTone) const {
+    return d ? d->render(tones, defaultTone) : QString();
+}
+
+QString QWStyleSheet::render(const QColor& seed, int lightTone, int darkTone, bool dark) const {
+    if (!d) {
+        return QString();
+    }
+    const State state = makeState(seed, lightTone, darkTone, dark);
+    {
+        const QMutexLocker locker(&d->mutex);
+        if (const QString* sheet = d->rendered.object(state)) {
+            return *sheet; // 隐式共享，不复制内容
+        }
+    }
+
+    const QWPaletteCache::Entry entry = QWPaletteCache::instance().acquire(seed, lightTone, darkTone);
+    const QString sheet = d->render(*entry.tones, dark ? darkTone : lightTone);
+    d->store(state, sheet);
+    return sheet;
+}
+
+void QWStyleSheet::prerender(const QColor& seed, int lightTone, int darkTone, bool dark) const {
+    if (!d) {
+        return;
+    }
+    const State state = makeState(seed, lightTone, darkTone, dark);
+    {
+        const QMutexLocker locker(&d->mutex);
+        if (d->rendered.contains(state) || d->pending.contains(state)) {
+            return;
+        }
+        d->pending.insert(state);
+    }
+
+    // 任务持有共享数据的引用，模板对象先被销毁也没有问题
+    QThreadPool::globalInstance()->start([data = d, state, seed, lightTone, darkTone, dark]() {
+        const QWPaletteCache::Entry entry = QWPaletteCache::instance().acquire(seed, lightTone, darkTone);
+        data->store(state, data->render(*entry.tones, dark ? darkTone : lightTone));
+    });
+}
+
+bool QWStyleSheet::isCached(const QColor& seed, int lightTone, int darkTone, bool dark) const {
+    if (!d) {
+        return false;
+    }
+    const QMutexLocker locker(&d->mutex);
+    return d->rendered.contains(makeState(seed, lightTone, darkTone, dark));
+}
+
+void QWStyleSheet::setCacheCapacity(int capacity) {
+    if (!d) {
+        return;
+    }
+    const QMutexLocker locker(&d->mutex);
+    d->rendered.setMaxCost(std::max(1, capacity));
+}
+
+int QWStyleSheet::cacheCapacity() const {
+    if (!d) {
+        return 0;
+    }
+    const QMutexLocker locker(&d->mutex);
+    return static_cast<int>(d->rendered.maxCost());
+}
+
+void QWStyleSheet::clearCache() {
+    if (!d) {
+        return;
+    }
+    const QMutexLocker locker(&d->mutex);
+    d->rendered.clear();
+}
+
+} // namespace QtWin
@@ -0,0 +1,270 @@
+#include "QtWin/QWThemeManager.h"
+
+#include <algorithm>
+#include <array>
+
+namespace QtWin {
+
+namespace {
+
+// createPalette 设置的颜色角色，顺序与 roleColors 的输出一致
+constexpr QPalette::ColorRole kRoles[] = {
+    QPalette::Window, QPalette::WindowText,
+    QPalette::Base, QPalette::AlternateBase, QPalette::Text,
+    QPalette::Button, QPalette::ButtonText,
+    QPalette::Highlight, QPalette::HighlightedText,
+    QPalette::Link, QPalette::LinkVisited
+};
+constexpr int kRoleCount = sizeof(kRoles) / sizeof(kRoles[0]);
+
+using RoleColors = std::array<QRgb, kRoleCount>;
+
+/** 只读取色调表，不涉及 QPalette，可以在后台线程中计算。 */
+RoleColors roleColors(const QWToneTable& tones, int lightTone, int darkTone, bool dark) {
+    const int tone = dark ? darkTone : lightTone;
+    const int textTone = dark ? lightTone : darkTone; // 文字使用相反模式的色调
+    const QRgb text = tones.rgb(QWPalette::neutralAccent, textTone);
+    return {
+        tones.rgb(QWPalette::neutralAccent, tone),
+        text,
+        tones.rgb(QWPalette::neutralColor, tone),
+        tones.rgb(QWPalette::neutralColor, tone + (dark ? 5 : -5)),
+        text,
+        tones.rgb(QWPalette::subColor, tone),
+        tones.rgb(QWPalette::subColor, textTone),
+        tones.rgb(QWPalette::accentColor, tone),
+        tones.rgb(QWPalette::accentColor, textTone),
+        tones.rgb(QWPalette::mainColor, tone),
+        tones.rgb(QWPalette::subColor, tone)
+    };
+}
+
+/**
+ * 默认色调满足对比度时保持不变，否则在默认色调一侧求出最接近背景且满足对比度的色调。
+ * side 为窗口背景色调：文字总是在它的同一侧（浅色模式更暗、深色模式更亮），
+ * 即使比较的背景（如 AlternateBase）恰好落在 50 附近也不会翻到另一侧。
+ */
+int readableTone(const QWPalette& palette, QWPalette::QWColor role, int preferredTone,
+                 QWPalette::QWColor backgroundRole, int backgroundTone, int side, double ratio) {
+    const double foreground = palette.relativeLuminance(role, preferredTone);
+    const double background = palette.relativeLuminance(backgroundRole, backgroundTone);
+    const double contrast = (std::max(foreground, background) + 0.05) / (std::min(foreground, background) + 0.05);
+    if (contrast >= ratio) {
+        return preferredTone;
+    }
+    const ContrastSearch search = preferredTone < side ? ContrastSearch::Darker
+                                : preferredTone > side ? ContrastSearch::Lighter
+                                : ContrastSearch::Auto;
+    return palette.toneForContrast(role, backgroundTone, ratio, backgroundRole, search);
+}
+
+/** 同 roleColors，文字角色保证最低对比度；只查亮度表，同样可以在后台线程中计算。 */
+RoleColors roleColors(const QWPaletteCache::Entry& colors, int lightTone, int darkTone, bool dark,
+                      double minimumContrast) {
+    RoleColors result = roleColors(*colors.tones, lightTone, darkTone, dark);
+    if (minimumContrast <= 0.0) {
+        return result;
+    }
+    const QWPalette& palette = *colors.palette;
+    const QWToneTable& tones = *colors.tones;
+    const int tone = std::clamp(dark ? darkTone : lightTone, 0, 100);
+    const int textTone = dark ? lightTone : darkTone;
+    const int baseTone = std::clamp(tone + (dark ? 5 : -5), 0, 100);
+    const auto readable = [&](QWPalette::QWColor role, int preferred, QWPalette::QWColor background, int backgroundTone) {
+        return tones.rgb(role, readableTone(palette, role, preferred, background, backgroundTone, tone, minimumContrast));
+    };
+    // 下标与 kRoles 的顺序一致
+    result[1] = readable(QWPalette::neutralAccent, textTone, QWPalette::neutralAccent, tone); // WindowText / Window
+    result[4] = readable(QWPalette::neutralAccent, textTone, QWPalette::neutralColor, baseTone); // Text / AlternateBase（对比度较低的一个）
+    result[6] = readable(QWPalette::subColor, textTone, QWPalette::subColor, tone);           // ButtonText / Button
+    result[8] = readable(QWPalette::accentColor, textTone, QWPalette::accentColor, tone);     // HighlightedText / Highlight
+    result[9] = readable(QWPalette::mainColor, tone, QWPalette::neutralAccent, tone);         // Link / Window
+    result[10] = readable(QWPalette::subColor, tone, QWPalette::neutralAccent, tone);         // LinkVisited / Window
+    return result;
+}
+
+/** 在应用调色板的基础上设置各角色，必须在 GUI 线程中调用。 */
+QPalette toPalette(const RoleColors& colors) {
+    QPalette palette;
+    for (int i = 0; i < kRoleCount; ++i) {
+        palette.setColor(kRoles[i], QColor(colors[i]));
+    }
+    return palette;
+}
+
+/** 两个 HCT 颜色之间的插值。 */
+HCTColor mixHct(const HCTColor& from, const HCTColor& to, double t) {
+    // 灰色（彩度接近 0）的色相没有意义，沿用另一端的色相，避免过渡途中色相旋转
+    const double fromHue = from.chroma < 1.0 ? to.hue : from.hue;
+    const double toHue = to.chroma < 1.0 ? fromHue : to.hue;
+    double delta = toHue - fromHue;
+    if (delta > 180.0) delta -= 360.0;
+    else if (delta < -180.0) delta += 360.0;
+    double hue = fromHue + delta * t;
+    if (hue < 0.0) hue += 360.0;
+    else if (hue >= 360.0) hue -= 360.0;
+    return HCTColor{hue, from.chroma + (to.chroma - from.chroma) * t, from.tone + (to.tone - from.tone) * t};
+}
+
+} // namespace
+
+QWThemeManager::QWThemeManager(QObject* parent)
+    : QObject(parent)
+{
+    m_themes.setMaxCost(16);
+    m_pool.setMaxThreadCount(1);
+    m_pool.setObjectName("QWThemeManager");
+}
+
+QWThemeManager::~QWThemeManager() {
+    // 预热任务会向本对象投递结果，必须在析构前结束
+    m_pool.waitForDone();
+}
+
+bool QWThemeManager::Key::operator==(const Key& other) const {
+    return colors == other.colors && contrast == other.contrast;
+}
+
+size_t qHash(const QWThemeManager::Key& key, size_t seed) noexcept {
+    return qHashMulti(seed, key.colors, key.contrast);
+}
+
+QWThemeManager::Key QWThemeManager::makeKey(const QColor& seed, int lightTone, int darkTone, double minimumContrast) {
+    return Key{QWPaletteCache::Key{seed.rgb(), lightTone, darkTone, GamutMapping::Clip},
+               qRound(std::max(0.0, minimumContrast) * 100.0)};
+}
+
+QPalette QWThemeManager::palette(const QColor& seed, int lightTone, int darkTone, bool dark, double minimumContrast) {
+    const Key key = makeKey(seed, lightTone, darkTone, minimumContrast);
+    Theme* theme = m_themes.object(key);
+    if (!theme) {
+        // 色调表就绪后另一个模式只是查表，两个模式一起构建，切换深浅色时直接换入
+        theme = new Theme;
+        theme->colors = QWPaletteCache::instance().acquire(seed, lightTone, darkTone);
+        for (int mode = 0; mode < 2; ++mode) {
+            theme->palettes[mode] = toPalette(roleColors(theme->colors, lightTone, darkTone, mode == 1,
+                                                         key.contrast / 100.0));
+        }
+        m_themes.insert(key, theme);
+    }
+    return theme->palettes[dark ? 1 : 0];
+}
+
+bool QWThemeManager::contains(const QColor& seed, int lightTone, int darkTone, bool dark, double minimumContrast) const {
+    Q_UNUSED(dark) // 两个模式总是一起构建
+    return m_themes.contains(makeKey(seed, lightTone, darkTone, minimumContrast));
+}
+
+void QWThemeManager::prewarm(const QColor& seed, int lightTone, int darkTone, double minimumContrast) {
+    const Key key = makeKey(seed, lightTone, darkTone, minimumContrast);
+    if (m_themes.contains(key) || m_warming.contains(key)) {
+        return;
+    }
+    m_warming.insert(key);
+    // 色调表与亮度表的 HCT 计算在后台完成；QPalette 的构造会读取应用调色板，回到 GUI 线程完成
+    m_pool.start([this, key, seed = QColor(seed.rgb())]() {
+        const QWPaletteCache::Entry entry = QWPaletteCache::instance().acquire(seed, key.colors.lightTone,
+                                                                               key.colors.darkTone);
+        const RoleColors light = roleColors(entry, key.colors.lightTone, key.colors.darkTone, false, key.contrast / 100.0);
+        const RoleColors dark = roleColors(entry, key.colors.lightTone, key.colors.darkTone, true, key.contrast / 100.0);
+        QMetaObject::invokeMethod(this, [this, key, entry, light, dark]() {
+            m_warming.remove(key);
+            if (m_themes.contains(key)) {
+                return; // 期间已经按需构建
+            }
+            auto* theme = new Theme;
+            theme->colors = entry;
+            theme->palettes[0] = toPalette(light);
+            theme->palettes[1] = toPalette(dark);
+            m_themes.insert(key, theme);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void QWThemeManager::insert(const QColor& seed, int lightTone, int darkTone, double minimumContrast,
+                            const QWPaletteCache::Entry& colors, const QPalette& light, const QPalette& dark) {
+    auto* theme = new Theme;
+    theme->colors = colors;
+    theme->palettes[0] = light;
+    theme->palettes[1] = dark;
+    m_themes.insert(makeKey(seed, lightTone, darkTone, minimumContrast), theme);
+}
+
+void QWThemeManager::setCapacity(int capacity) {
+    m_themes.setMaxCost(std::max(1, capacity));
+}
+
+int QWThemeManager::capacity() const {
+    return static_cast<int>(m_themes.maxCost());
+}
+
+void QWThemeManager::clear() {
+    m_themes.clear();
+}
+
+QPalette QWThemeManager::createPalette(const QWToneTable& tones, int lightTone, int darkTone, bool dark) {
+    return toPalette(roleColors(tones, lightTone, darkTone, dark));
+}
+
+QPalette QWThemeManager::createPalette(const QWPaletteCache::Entry& colors, int lightTone, int darkTone, bool dark,
+                                       double minimumContrast) {
+    return toPalette(roleColors(colors, lightTone, darkTone, dark, minimumContrast));
+}
+
+quint32 QWThemeManager::changedRoles(const QPalette& from, const QPalette& to) {
+    static_assert(QPalette::NColorRoles <= 32, "role mask must fit in 32 bits");
+    quint32 roles = 0;
+    for (int role = 0; role < QPalette::NColorRoles; ++role) {
+        for (QPalette::ColorGroup group : {QPalette::Active, QPalette::Inactive, QPalette::Disabled}) {
+            const auto colorRole = static_cast<QPalette::ColorRole>(role);
+            if (from.color(group, colorRole) != to.color(group, colorRole)) {
+                roles |= 1u << role;
+                break;
+            }
+        }
+    }
+    return roles;
+}
+
+std::vector<QPalette> QWThemeManager::interpolate(const QPalette& from, const QPalette& to, int steps) {
+    steps = std::max(1, steps);
+    std::vector<QPalette::ColorRole> roles;
+    std::vector<HCTColor> start;
+    std::vector<HCTColor> end;
+    const quint32 mask = changedRoles(from, to);
+    for (int role = 0; role < QPalette::NColorRoles; ++role) {
+        if (mask & (1u << role)) {
+            const auto colorRole = static_cast<QPalette::ColorRole>(role);
+            roles.push_back(colorRole);
+            start.push_back(RGB2HCT(RGBColor(from.color(colorRole))));
+            end.push_back(RGB2HCT(RGBColor(to.color(colorRole))));
+        }
+    }
+
+    // 中间帧的全部颜色一次批量转换回 sRGB
+    const size_t count = roles.size();
+    std::vector<HCTColor> hct(count * (steps - 1));
+    for (int step = 1; step < steps; ++step) {
+        const double t = double(step) / steps;
+        for (size_t i = 0; i < count; ++i) {
+            hct[(step - 1) * count + i] = mixHct(start[i], end[i], t);
+        }
+    }
+    std::vector<RGBColor> rgb(hct.size());
+    HCT2RGB(hct.data(), rgb.data(), static_cast<qsizetype>(hct.size()));
+
+    std::vector<QPalette> frames;
+    frames.reserve(steps);
+    for (int step = 1; step < steps; ++step) {
+        QPalette frame = to;
+        for (size_t i = 0; i < count; ++i) {
+            const RGBColor& color = rgb[(step - 1) * count + i];
+            frame.setColor(roles[i], QColor(color.red, color.green, color.blue));
+        }
+        frames.push_back(frame);
+    }
+    frames.push_back(to);
+    return frames;
+}
+
+} // namespace QtWin
@@ -0,0 +1,214 @@
+#include "QtWin/QWThemeSnapshot.h"
+#include "QtWin/QWLogger.h"
+#include "QtWin/QWSettings.h"
+#include "QtWin/QWThemeManager.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include <vector>
+
+#ifndef QTWIN_VERSION
+#define QTWIN_VERSION "0.0.0"
+#endif
+
+QWLOGNAME(qtwinSnapshotLogger,"qtwin.core.snapshot")
+
+namespace QtWin {
+
+namespace {
+
+// 文件格式：magic + version + 负载 + 负载的 CRC-16
+//   负载：库版本 | 种子 QRgb | 种子 HCT | 浅/深色调 | 最低对比度 | 色调表 | 浅色、深色 QPalette
+// 负载中的任何字段变化都需要增加 kVersion
+constexpr quint32 kMagic = 0x51575453; // "QWTS"
+constexpr quint16 kVersion = 1;
+constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_6_0;
+constexpr int kToneValues = QWToneTable::kRoleCount * QWToneTable::kToneCount;
+
+} // namespace
+
+QWThemeSnapshot::QWThemeSnapshot() = default;
+
+QWThemeSnapshot QWThemeSnapshot::capture(const QColor& seed, int lightTone, int darkTone,
+                                         double minimumTextContrast, QWThemeManager* manager) {
+    const QWPaletteCache::Entry colors = QWPaletteCache::instance().acquire(seed, lightTone, darkTone);
+
+    QWThemeSnapshot snapshot;
+    snapshot.m_seed = QColor(seed.rgb());
+    snapshot.m_seedHct = RGB2HCT(RGBColor(snapshot.m_seed));
+    snapshot.m_lightTone = lightTone;
+    snapshot.m_darkTone = darkTone;
+    snapshot.m_minimumTextContrast = minimumTextContrast;
+    snapshot.m_tones = colors.tones;
+    for (int mode = 0; mode < 2; ++mode) {
+        snapshot.m_palettes[mode] = manager
+            ? manager->palette(seed, lightTone, darkTone, mode == 1, minimumTextContrast)
+            : QWThemeManager::createPalette(colors, lightTone, darkTone, mode == 1, minimumTextContrast);
+    }
+    return snapshot;
+}
+
+bool QWThemeSnapshot::isValid() const {
+    return !m_tones.isNull();
+}
+
+QColor QWThemeSnapshot::seedColor() const { return m_seed; }
+int QWThemeSnapshot::lightTone() const { return m_lightTone; }
+int QWThemeSnapshot::darkTone() const { return m_darkTone; }
+double QWThemeSnapshot::minimumTextContrast() const { return m_minimumTextContrast; }
+
+QWPaletteCache::Entry QWThemeSnapshot::colors() const {
+    QWPaletteCache::Entry entry;
+    if (isValid()) {
+        // QWPalette(HCTColor) 只做几次乘法，不经过颜色转换
+        entry.palette = QSharedPointer<const QWPalette>::create(m_seedHct);
+        entry.tones = m_tones;
+    }
+    return entry;
+}
+
+QPalette QWThemeSnapshot::palette(bool dark) const {
+    return m_palettes[dark ? 1 : 0];
+}
+
+bool QWThemeSnapshot::matches(const QColor& seed, int lightTone, int darkTone, double minimumTextContrast) const {
+    return isValid()
+        && m_seed.rgb() == seed.rgb()
+        && m_lightTone == lightTone
+        && m_darkTone == darkTone
+        && qRound(m_minimumTextContrast * 100.0) == qRound(minimumTextContrast * 100.0);
+}
+
+void QWThemeSnapshot::restore(QWThemeManager* manager) const {
+    if (!isValid()) {
+        return;
+    }
+    const QWPaletteCache::Entry entry = QWPaletteCache::instance().insert(m_seed, m_lightTone, m_darkTone, colors());
+    if (manager) {
+        manager->insert(m_seed, m_lightTone, m_darkTone, m_minimumTextContrast, entry, m_palettes[0], m_palettes[1]);
+    }
+}
+
+QByteArray QWThemeSnapshot::toByteArray() const {
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    QByteArray payload;
+    {
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(kStreamVersion);
+        stream << QString::fromLatin1(QTWIN_VERSION)
+               << quint32(m_seed.rgb())
+               << m_seedHct.hue << m_seedHct.chroma << m_seedHct.tone
+               << qint32(m_lightTone) << qint32(m_darkTone) << m_minimumTextContrast;
+        const QRgb* tones = m_tones->data();
+        for (int i = 0; i < kToneValues; ++i) {
+            stream << quint32(tones[i]);
+        }
+        stream << m_palettes[0] << m_palettes[1];
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(kStreamVersion);
+    stream << kMagic << kVersion << payload << qChecksum(payload);
+    return data;
+}
+
+QWThemeSnapshot QWThemeSnapshot::fromByteArray(const QByteArray& data) {
+    if (data.isEmpty()) {
+        return QWThemeSnapshot();
+    }
+
+    QDataStream outer(data);
+    outer.setVersion(kStreamVersion);
+    quint32 magic = 0;
+    quint16 version = 0;
+    QByteArray payload;
+    quint16 checksum = 0;
+    outer >> magic >> version;
+    if (outer.status() != QDataStream::Ok || magic != kMagic || version != kVersion) {
+        qwLogger(LogLevel::Info,qtwinSnapshotLogger) << "Ignoring theme snapshot with unknown format";
+        return QWThemeSnapshot();
+    }
+    outer >> payload >> checksum;
+    if (outer.status() != QDataStream::Ok || checksum != qChecksum(payload)) {
+        qwLogger(LogLevel::Warning,qtwinSnapshotLogger) << "Ignoring corrupted theme snapshot";
+        return QWThemeSnapshot();
+    }
+
+    QDataStream stream(payload);
+    stream.setVersion(kStreamVersion);
+    QString libraryVersion;
+    stream >> libraryVersion;
+    if (libraryVersion != QLatin1StringView(QTWIN_VERSION)) {
+        // 颜色算法可能已经变化，快照只在同一版本的库中有效
+        qwLogger(LogLevel::Info,qtwinSnapshotLogger) << "Ignoring theme snapshot from QtWin" << libraryVersion;
+        return QWThemeSnapshot();
+    }
+
+    QWThemeSnapshot snapshot;
+    quint32 seed = 0;
+    qint32 lightTone = 0;
+    qint32 darkTone = 0;
+    stream >> seed >> snapshot.m_seedHct.hue >> snapshot.m_seedHct.chroma >> snapshot.m_seedHct.tone
+           >> lightTone >> darkTone >> snapshot.m_minimumTextContrast;
+    std::vector<QRgb> tones(kToneValues);
+    for (QRgb& tone : tones) {
+        quint32 value = 0;
+        stream >> value;
+        tone = value;
+    }
+    stream >> snapshot.m_palettes[0] >> snapshot.m_palettes[1];
+    if (stream.status() != QDataStream::Ok || !stream.atEnd()) {
+        qwLogger(LogLevel::Warning,qtwinSnapshotLogger) << "Ignoring malformed theme snapshot";
+        return QWThemeSnapshot();
+    }
+
+    snapshot.m_seed = QColor::fromRgb(seed);
+    snapshot.m_lightTone = lightTone;
+    snapshot.m_darkTone = darkTone;
+    snapshot.m_tones = QSharedPointer<const QWToneTable>::create(tones.data());
+    return snapshot;
+}
+
+void QWThemeSnapshot::save(QWSettings* settings, const QString& key) const {
+    if (!settings) {
+        return;
+    }
+    if (isValid()) {
+        settings->setValue(key, toByteArray());
+    } else {
+        settings->remove(key);
+    }
+}
+
+QWThemeSnapshot QWThemeSnapshot::load(const QWSettings* settings, const QString& key) {
+    if (!settings) {
+        return QWThemeSnapshot();
+    }
+    return fromByteArray(settings->value(key).toByteArray());
+}
+
+bool QWThemeSnapshot::saveToFile(const QString& path) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qwLogger(LogLevel::Warning,qtwinSnapshotLogger) << "Could not write theme snapshot:" << path;
+        return false;
+    }
+    file.write(toByteArray());
+    return file.commit();
+}
+
+QWThemeSnapshot QWThemeSnapshot::loadFromFile(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QWThemeSnapshot();
+    }
+    return fromByteArray(file.readAll());
+}
+
+} // namespace QtWin
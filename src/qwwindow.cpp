@@ -1,9 +1,16 @@
 #include "QtWin/QWWindow.h"
 #include "QtWin/QWApplication.h"
+#include "QtWin/QWLogger.h"
+#include "QtWin/QWThemeManager.h"
 
 #include <QVBoxLayout>
+#include <QPaintEvent>
 #include <QPainter>
+#include <QScreen>
 #include <QShowEvent>
+#include <QTimer>
+
+#include <algorithm>
 
 #ifdef Q_OS_WIN
 #include <dwmapi.h>
@@ -22,6 +29,8 @@
 #define DWMSBT_NONE 1
 #endif
 
+QWLOGNAME(qtwinWindowLogger,"qtwin.core.window")
+
 namespace QtWin {
 
 QWWindow::QWWindow(QWidget *parent)
@@ -32,13 +41,37 @@ QWWindow::QWWindow(QWidget *parent)
         m_darkTone(20),
         m_isDarkMode(false), // 初始值会被initialize覆盖
         m_material(Acrylic),
-        m_firstShow(true)
+        m_firstShow(true),
+        m_themeDirty(false),
+        m_themeUpdateQueued(false),
+        m_themeBatchDepth(0),
+        m_pendingSignals(0),
+        m_paletteUpdateMode(FullTree),
+        m_minimumTextContrast(0.0),
+        m_transitionDuration(0),
+        m_transitionTimer(nullptr),
+        m_transitionFrame(-1),
+        m_transitionNextFrame(0),
+        m_paintLogInterval(0)
 {
     initialize();
 }
 
 QWWindow::~QWWindow() = default;
 
+QWWindow::ThemeBatch::ThemeBatch(QWWindow *window)
+    : m_window(window)
+{
+    ++m_window->m_themeBatchDepth;
+}
+
+QWWindow::ThemeBatch::~ThemeBatch() {
+    if (--m_window->m_themeBatchDepth == 0) {
+        // 最外层守卫结束：立即应用，之后已投递的延迟应用会发现没有待更新的修改
+        m_window->applyPendingTheme();
+    }
+}
+
 void QWWindow::initialize() {
     m_rootLayout = new QVBoxLayout(this);
     m_rootLayout->setContentsMargins(0, 0, 0, 0);
@@ -49,8 +82,18 @@ void QWWindow::initialize() {
         connect(QWApplication::instance(), &QWApplication::darkModeChanged, this, &QWWindow::onThemeChanged);
     }
     
-    m_palette.setSeedColor(QColor(19, 149, 192));
+    m_seedColor = QColor(19, 149, 192);
+    if (QWApplication::instance() && QWApplication::instance()->themeSnapshot().isValid()) {
+        // 采用启动时恢复的快照：下面的调色板与 QPalette 都直接命中缓存
+        const QWThemeSnapshot& snapshot = QWApplication::instance()->themeSnapshot();
+        m_seedColor = snapshot.seedColor();
+        m_lightTone = snapshot.lightTone();
+        m_darkTone = snapshot.darkTone();
+        m_minimumTextContrast = snapshot.minimumTextContrast();
+    }
+    refreshColorTheme();
     resize(800, 600);
+    updatePaintAttributes();
     
     // 初始化调色板
     setupPalettes();
@@ -71,23 +114,23 @@ void QWWindow::setCentralWidget(QWidget *widget) {
         m_centralWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     }
     
-    // 每当设置新的中心控件时，立即应用当前的主题和样式
-    updateCustomTheme(); 
+    // 每当设置新的中心控件时，应用当前的主题和样式
+    requestThemeUpdate();
 }
 
 QWidget* QWWindow::centralWidget() const { return m_centralWidget; }
-QColor QWWindow::seedColor() const { return m_palette.getQColor(QWPalette::mainColor, 50); }
+QColor QWWindow::seedColor() const { return m_seedColor; }
 QWWindow::MaterialType QWWindow::material() const { return m_material; }
 int QWWindow::lightTone() const { return m_lightTone; }
 int QWWindow::darkTone() const { return m_darkTone; }
 
 const QWPalette& QWWindow::colorPalette() const {
-    return m_palette;
+    return *m_colorTheme.palette;
 }
 
 QColor QWWindow::getThemeColor(QWPalette::QWColor colorRole, int toneOverride) const {
     int tone = (toneOverride == -1) ? currentTone() : toneOverride;
-    return m_palette.getQColor(colorRole, tone);
+    return m_colorTheme.tones->color(colorRole, tone);
 }
 
 int QWWindow::currentTone() const {
@@ -98,12 +141,51 @@ bool QWWindow::isDarkMode() const {
     return m_isDarkMode;
 }
 
+void QWWindow::setPaletteUpdateMode(PaletteUpdateMode mode) {
+    if (m_paletteUpdateMode == mode) return;
+    m_paletteUpdateMode = mode;
+    requestThemeUpdate();
+}
+
+QWWindow::PaletteUpdateMode QWWindow::paletteUpdateMode() const {
+    return m_paletteUpdateMode;
+}
+
+void QWWindow::setThemeTransitionDuration(int msecs) {
+    m_transitionDuration = std::max(0, msecs);
+}
+
+int QWWindow::themeTransitionDuration() const {
+    return m_transitionDuration;
+}
+
+void QWWindow::setMinimumTextContrast(double ratio) {
+    ratio = std::max(0.0, ratio);
+    if (qFuzzyCompare(m_minimumTextContrast + 1.0, ratio + 1.0)) return;
+    m_minimumTextContrast = ratio;
+    requestThemeUpdate();
+}
+
+double QWWindow::minimumTextContrast() const {
+    return m_minimumTextContrast;
+}
+
+void QWWindow::registerThemedWidget(QWidget *widget) {
+    if (!widget || m_themedWidgets.contains(widget)) return;
+    m_themedWidgets.append(widget);
+    applyThemeRoles(widget);
+}
+
+void QWWindow::unregisterThemedWidget(QWidget *widget) {
+    m_themedWidgets.removeAll(widget);
+}
+
 void QWWindow::setSeedColor(const QColor &color) {
-    if (seedColor() != color) {
-        m_palette.setSeedColor(RGBColor(color));
-        setupPalettes(); // 重新设置调色板
-        updateCustomTheme();
-        emit seedColorChanged(color);
+    if (m_seedColor != color) {
+        m_seedColor = color;
+        refreshColorTheme();
+        m_pendingSignals |= SeedColorSignal;
+        requestThemeUpdate();
     }
 }
 
@@ -113,27 +195,27 @@ void QWWindow::setMaterial(QWWindow::MaterialType type) {
 
     // 更新DWM框架，应用或移除材质
     updateFrame();
+    updatePaintAttributes();
     // 更新Qt部分的样式
-    updateCustomTheme();
-
-    emit materialChanged(type);
+    m_pendingSignals |= MaterialSignal;
+    requestThemeUpdate();
 }
 
 void QWWindow::setLightTone(int tone) {
     if (m_lightTone != tone) {
         m_lightTone = tone;
-        setupPalettes(); // 重新设置调色板
-        updateCustomTheme();
-        emit toneChanged();
+        refreshColorTheme();
+        m_pendingSignals |= ToneSignal;
+        requestThemeUpdate();
     }
 }
 
 void QWWindow::setDarkTone(int tone) {
     if (m_darkTone != tone) {
         m_darkTone = tone;
-        setupPalettes(); // 重新设置调色板
-        updateCustomTheme();
-        emit toneChanged();
+        refreshColorTheme();
+        m_pendingSignals |= ToneSignal;
+        requestThemeUpdate();
     }
 }
 
@@ -161,73 +243,178 @@ void QWWindow::updateFrame() {
 #endif
 }
 
+QWThemeSnapshot QWWindow::themeSnapshot() const {
+    return QWThemeSnapshot::capture(m_seedColor, m_lightTone, m_darkTone, m_minimumTextContrast,
+                                    QWApplication::instance() ? QWApplication::instance()->themeManager() : nullptr);
+}
+
+void QWWindow::refreshColorTheme() {
+    // 相同种子和色调的窗口共享同一份调色板，命中缓存时只是一次哈希查找
+    m_colorTheme = QWPaletteCache::instance().acquire(m_seedColor, m_lightTone, m_darkTone);
+}
+
 void QWWindow::setupPalettes() {
-    QPalette windowPalette = palette();
-    
-    // 为窗口设置主要的色彩角色
-    QColor windowBg = getThemeColor(QWPalette::neutralAccent);
-    QColor windowText = getThemeColor(QWPalette::neutralAccent, m_isDarkMode ? m_lightTone : m_darkTone);
-    QColor base = getThemeColor(QWPalette::neutralColor);
-    QColor alternateBase = getThemeColor(QWPalette::neutralColor, currentTone() + (m_isDarkMode ? 5 : -5));
-    
-    // 设置窗口背景色
-    windowPalette.setColor(QPalette::Window, windowBg);
-    windowPalette.setColor(QPalette::WindowText, windowText);
-    
-    // 设置输入控件背景色
-    windowPalette.setColor(QPalette::Base, base);
-    windowPalette.setColor(QPalette::AlternateBase, alternateBase);
-    windowPalette.setColor(QPalette::Text, windowText);
-    
-    // 设置按钮相关色彩
-    QColor buttonBg = getThemeColor(QWPalette::subColor);
-    QColor buttonText = getThemeColor(QWPalette::subColor, m_isDarkMode ? m_lightTone : m_darkTone);
-    windowPalette.setColor(QPalette::Button, buttonBg);
-    windowPalette.setColor(QPalette::ButtonText, buttonText);
-    
-    // 设置高亮色彩
-    QColor highlight = getThemeColor(QWPalette::accentColor);
-    QColor highlightText = getThemeColor(QWPalette::accentColor, m_isDarkMode ? m_lightTone : m_darkTone);
-    windowPalette.setColor(QPalette::Highlight, highlight);
-    windowPalette.setColor(QPalette::HighlightedText, highlightText);
-    
-    // 设置链接色彩
-    QColor link = getThemeColor(QWPalette::mainColor);
-    QColor visitedLink = getThemeColor(QWPalette::subColor);
-    windowPalette.setColor(QPalette::Link, link);
-    windowPalette.setColor(QPalette::LinkVisited, visitedLink);
-    
-    // 应用调色板到窗口
-    setPalette(windowPalette);
-    
-    // 如果有中心控件，也为其设置调色板
-    if (m_centralWidget) {
-        m_centralWidget->setPalette(windowPalette);
+    // 相同种子和色调的窗口共享 QWThemeManager 构建好的 QPalette，
+    // 切换深浅色时只是换入现成的（与当前模式一起构建的）调色板
+    const QPalette windowPalette = QWApplication::instance()
+        ? QWApplication::instance()->themeManager()->palette(m_seedColor, m_lightTone, m_darkTone, m_isDarkMode,
+                                                             m_minimumTextContrast)
+        : QWThemeManager::createPalette(m_colorTheme, m_lightTone, m_darkTone, m_isDarkMode, m_minimumTextContrast);
+
+    // 窗口可见且颜色确实变化时逐帧过渡，否则立即应用
+    if (m_transitionDuration > 0 && isVisible()
+        && QWThemeManager::changedRoles(m_themePalette, windowPalette) != 0) {
+        startThemeTransition(windowPalette);
+        return;
+    }
+    if (m_transitionTimer) {
+        m_transitionTimer->stop();
+        m_transitionFrames.clear();
     }
+    applyThemePalette(windowPalette);
 }
 
-void QWWindow::updateCustomTheme() {
-    if (m_material != Default) {
-        // 材质模式：清除样式表，让透明背景生效
-        setStyleSheet("");
-        if (m_centralWidget) {
-            m_centralWidget->setStyleSheet("");
+void QWWindow::applyThemePalette(const QPalette &themePalette) {
+    m_themePalette = themePalette;
+
+    if (m_paletteUpdateMode == FullTree) {
+        // 子控件从窗口继承调色板，不再单独设置中心控件。
+        // 没有任何角色变化时不设置，避免 Qt 遍历整个控件树发送 PaletteChange
+        if (QWThemeManager::changedRoles(palette(), themePalette) != 0) {
+            setPalette(themePalette);
         }
-    } else {
-        // Default模式：也清除样式表，完全依赖QPalette系统
-        setStyleSheet("");
-        if (m_centralWidget) {
-            m_centralWidget->setStyleSheet("");
+        return;
+    }
+
+    for (auto it = m_themedWidgets.begin(); it != m_themedWidgets.end();) {
+        if (it->isNull()) {
+            it = m_themedWidgets.erase(it);
+            continue;
         }
+        applyThemeRoles(*it);
+        ++it;
     }
-    
-    // 重新设置调色板以确保颜色更新
+    update();
+}
+
+void QWWindow::startThemeTransition(const QPalette &target) {
+    // 每个刷新周期一帧；从当前显示的调色板出发，打断进行中的过渡时不会跳变
+    const qreal refreshRate = screen() ? std::max<qreal>(screen()->refreshRate(), 1.0) : 60.0;
+    const int frameInterval = std::max(1, qRound(1000.0 / refreshRate));
+    const int frames = std::max(2, m_transitionDuration / frameInterval);
+    m_transitionFrames = QWThemeManager::interpolate(m_themePalette, target, frames);
+    m_transitionFrame = -1;
+    m_transitionNextFrame = 0;
+
+    if (!m_transitionTimer) {
+        m_transitionTimer = new QTimer(this);
+        m_transitionTimer->setTimerType(Qt::PreciseTimer);
+        connect(m_transitionTimer, &QTimer::timeout, this, &QWWindow::advanceThemeTransition);
+    }
+    m_transitionTimer->setInterval(frameInterval);
+    m_transitionClock.start();
+    m_transitionTimer->start();
+    advanceThemeTransition(); // 第一帧立即应用
+}
+
+void QWWindow::advanceThemeTransition() {
+    const qint64 elapsed = m_transitionClock.elapsed();
+    const bool finished = elapsed >= m_transitionDuration;
+    if (!finished && elapsed < m_transitionNextFrame) {
+        return; // 上一帧超出预算，跳过本帧，把时间留给绘制
+    }
+
+    const int count = static_cast<int>(m_transitionFrames.size());
+    const int frame = finished ? count - 1
+        : std::min<int>(count - 1, static_cast<int>(elapsed * count / m_transitionDuration));
+    if (frame > m_transitionFrame) {
+        QElapsedTimer cost;
+        cost.start();
+        applyThemePalette(m_transitionFrames[frame]);
+        m_transitionFrame = frame;
+
+        // 每帧预算为半个刷新周期，超出多少就推迟多少，定时器事件不会排队
+        const qint64 spent = cost.elapsed();
+        m_transitionNextFrame = spent > m_transitionTimer->interval() / 2 ? elapsed + spent : 0;
+    }
+
+    if (finished) {
+        m_transitionTimer->stop();
+        m_transitionFrames.clear();
+    }
+}
+
+void QWWindow::applyThemeRoles(QWidget *widget) {
+    // 只写入发生变化的角色，Qt 只在该子树内传播
+    const quint32 roles = QWThemeManager::changedRoles(widget->palette(), m_themePalette);
+    if (roles == 0) return;
+
+    QPalette widgetPalette = widget->palette();
+    for (int role = 0; role < QPalette::NColorRoles; ++role) {
+        if (!(roles & (1u << role))) continue;
+        const auto colorRole = static_cast<QPalette::ColorRole>(role);
+        for (QPalette::ColorGroup group : {QPalette::Active, QPalette::Inactive, QPalette::Disabled}) {
+            widgetPalette.setColor(group, colorRole, m_themePalette.color(group, colorRole));
+        }
+    }
+    widget->setPalette(widgetPalette);
+}
+
+void QWWindow::updateCustomTheme() {
+    // 材质模式与 Default 模式都完全依赖 QPalette，样式表只来自主题模板。
+    // 内容没有变化时不再设置，避免触发一次无用的重新解析与 polish
+    if (!m_themeStyleSheet.isNull()) {
+        const QString sheet = m_themeStyleSheet.render(m_seedColor, m_lightTone, m_darkTone, m_isDarkMode);
+        if (styleSheet() != sheet) {
+            setStyleSheet(sheet);
+        }
+        m_themeStyleSheet.prerender(m_seedColor, m_lightTone, m_darkTone, !m_isDarkMode);
+    } else if (!styleSheet().isEmpty()) {
+        setStyleSheet(QString());
+    }
+    if (m_centralWidget && !m_centralWidget->styleSheet().isEmpty()) {
+        m_centralWidget->setStyleSheet(QString());
+    }
+
     setupPalettes();
-    
+
     // 触发重绘
     update();
 }
 
+void QWWindow::requestThemeUpdate() {
+    // 只做标记：连续的多次修改在下一轮事件循环（或最外层 ThemeBatch 结束时）合并为一次应用
+    m_themeDirty = true;
+    if (m_themeBatchDepth > 0 || m_themeUpdateQueued) {
+        return;
+    }
+    m_themeUpdateQueued = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        m_themeUpdateQueued = false;
+        applyPendingTheme();
+    }, Qt::QueuedConnection);
+}
+
+void QWWindow::applyPendingTheme() {
+    if (!m_themeDirty || m_themeBatchDepth > 0) {
+        return;
+    }
+    m_themeDirty = false;
+    updateCustomTheme();
+    emitPendingSignals();
+}
+
+void QWWindow::emitPendingSignals() {
+    // 信号在 QPalette 应用之后发出，槽函数读取 palette() 时已是新颜色。
+    // 先清除再发出：槽函数中的修改会重新标记，留给下一次应用
+    const int pending = m_pendingSignals;
+    m_pendingSignals = 0;
+    if (pending & SeedColorSignal) emit seedColorChanged(m_seedColor);
+    if (pending & ToneSignal) emit toneChanged();
+    if (pending & MaterialSignal) emit materialChanged(m_material);
+    if (pending & ThemeSignal) emit themeChanged(m_isDarkMode);
+}
+
 void QWWindow::onThemeChanged(bool isDark) {
     if (m_isDarkMode == isDark) return;
     m_isDarkMode = isDark;
@@ -241,31 +428,103 @@ void QWWindow::onThemeChanged(bool isDark) {
 //     }
 // #endif
 
-    // 更新内部控件的主题
-    updateCustomTheme();
-    
-    // 发出主题变化信号
-    emit themeChanged(isDark);
+    // 更新内部控件的主题，应用后发出主题变化信号
+    m_pendingSignals |= ThemeSignal;
+    requestThemeUpdate();
 }
 
 void QWWindow::showEvent(QShowEvent *event) {
     QWidget::showEvent(event);
     if (m_firstShow && windowHandle()) {
-        updateFrame(); 
+        updateFrame();
+        updatePaintAttributes();
         onThemeChanged(m_isDarkMode);
         m_firstShow = false;
+        if (QWApplication::instance()) {
+            QWApplication::instance()->markFirstWindowShown();
+        }
+    }
+}
+
+void QWWindow::setThemeStyleSheet(const QWStyleSheet &sheet) {
+    m_themeStyleSheet = sheet;
+    requestThemeUpdate();
+}
+
+QWStyleSheet QWWindow::themeStyleSheet() const { return m_themeStyleSheet; }
+
+QWWindow::PaintStats QWWindow::paintStats() const { return m_paintStats; }
+
+void QWWindow::resetPaintStats() {
+    m_paintStats = PaintStats();
+    m_paintLogWindow = PaintStats();
+}
+
+void QWWindow::setPaintStatsLogInterval(int paints) {
+    m_paintLogInterval = std::max(0, paints);
+    m_paintLogWindow = PaintStats();
+}
+
+int QWWindow::paintStatsLogInterval() const { return m_paintLogInterval; }
+
+void QWWindow::updatePaintAttributes() {
+    // 不透明的窗口由 paintEvent 填满暴露区域，Qt 无需先擦除背景；
+    // 透明背景（Windows 上的材质模式）需要露出 DWM 材质，不能声明为不透明
+    setAttribute(Qt::WA_OpaquePaintEvent, !testAttribute(Qt::WA_TranslucentBackground));
+}
+
+void QWWindow::recordPaint(qint64 nsecs, quint64 area) {
+    for (PaintStats *stats : {&m_paintStats, &m_paintLogWindow}) {
+        ++stats->paints;
+        stats->totalNsecs += nsecs;
+        stats->maxNsecs = std::max(stats->maxNsecs, nsecs);
+        stats->lastNsecs = nsecs;
+        stats->totalArea += area;
+        stats->lastArea = area;
+    }
+
+    if (m_paintLogInterval > 0 && m_paintLogWindow.paints >= quint64(m_paintLogInterval)) {
+        const PaintStats &window = m_paintLogWindow;
+        qwLogger(LogLevel::Debug,qtwinWindowLogger) << objectName() << "paints:" << window.paints
+            << ", mean us:" << window.totalNsecs / 1000.0 / window.paints
+            << ", max us:" << window.maxNsecs / 1000.0
+            << ", mean area:" << window.totalArea / window.paints;
+        m_paintLogWindow = PaintStats();
     }
 }
 
 void QWWindow::paintEvent(QPaintEvent *event) {
-    if (m_material != Default) {
-        // 材质模式：手动绘制透明背景
-        QPainter painter(this);
-        painter.fillRect(rect(), Qt::transparent);
+    QElapsedTimer timer;
+    timer.start();
+
+    // 只处理暴露区域的各个矩形，调整大小或滚动时不必重绘整个窗口
+    const QRegion &region = event->region();
+    quint64 area = 0;
+    for (const QRect &rect : region) {
+        area += quint64(rect.width()) * quint64(rect.height());
+    }
+
+    QPainter painter(this);
+    if (testAttribute(Qt::WA_TranslucentBackground)) {
+        // 透明背景（Windows 上的材质模式）：暴露区域清为透明，露出 DWM 材质
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const QRect &rect : region) {
+            painter.fillRect(rect, Qt::transparent);
+        }
     } else {
-        // Default模式：使用标准的Qt绘制流程，依赖QPalette
-        QWidget::paintEvent(event);
+        // 不透明的窗口（Default 模式，以及其他平台上的材质模式）声明了 WA_OpaquePaintEvent，
+        // 由这里填满背景；清为透明会在不透明的后备存储上留下黑色。
+        // RegisteredSubtrees 模式下窗口本身的调色板不跟随主题，按当前主题绘制
+        const QBrush background = m_paletteUpdateMode == RegisteredSubtrees
+            ? m_themePalette.window()
+            : palette().window();
+        for (const QRect &rect : region) {
+            painter.fillRect(rect, background);
+        }
     }
+    painter.end();
+
+    recordPaint(timer.nsecsElapsed(), area);
 }
 
 } // namespace QtWin
\ No newline at end of file
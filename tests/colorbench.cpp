@@ -0,0 +1,538 @@
+// QtWin/tests/colorbench.cpp
+//
+// 颜色转换的精度与性能基准。
+// 对全部 16.7M 个 sRGB 颜色做往返转换，报告最大/平均 ΔE，
+// 并测量标量、批量、查表路径的单次转换耗时，以及调色板构建和查询的开销。
+// 任何精度门限不满足时返回非零退出码。
+
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QImageReader>
+#include <QTemporaryDir>
+
+#include <QtWin/QWIconTinter.h>
+#include <QtWin/QWPalette.h>
+#include <QtWin/QWPaletteCache.h>
+#include <QtWin/QWSeedCache.h>
+#include <QtWin/QWSeedExtractor.h>
+#include <QtWin/QWSeedTracker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace QtWin;
+
+namespace {
+
+constexpr qint64 kColorCount = 256 * 256 * 256;
+
+// 与 tst_qwpalette.cpp 中的门限保持一致
+constexpr double kMaxRoundTripDeltaE = 0.5;
+constexpr int kMaxRoundTripChannelError = 1;
+constexpr int kMaxPrecisionChannelError = 1; // Float / Fixed 相对 Exact
+
+volatile double g_sink = 0.0; // 防止编译器优化掉被测代码
+
+double deltaE(const HCTColor& x, const HCTColor& y) {
+    const double ax = x.chroma * std::cos(x.hue * M_PI / 180.0);
+    const double bx = x.chroma * std::sin(x.hue * M_PI / 180.0);
+    const double ay = y.chroma * std::cos(y.hue * M_PI / 180.0);
+    const double by = y.chroma * std::sin(y.hue * M_PI / 180.0);
+    const double dl = x.tone - y.tone;
+    return std::sqrt(dl * dl + (ax - ay) * (ax - ay) + (bx - by) * (bx - by));
+}
+
+RGBColor colorAt(qint64 i) {
+    return RGBColor(int(i >> 16) & 0xFF, int(i >> 8) & 0xFF, int(i) & 0xFF);
+}
+
+void report(const char* name, qint64 nsecs, qint64 count) {
+    std::printf("  %-40s %10.1f ns/op  (%lld ops)\n", name, double(nsecs) / double(count), count);
+}
+
+bool gate(const char* name, bool passed) {
+    std::printf("  [%s] %s\n", passed ? "PASS" : "FAIL", name);
+    return passed;
+}
+
+bool benchRoundTrip() {
+    std::printf("Exhaustive round trip (RGB -> HCT -> RGB)\n");
+    int maxChannelError = 0;
+    double maxDeltaE = 0.0;
+    double sumDeltaE = 0.0;
+    for (qint64 i = 0; i < kColorCount; ++i) {
+        const RGBColor rgb = colorAt(i);
+        const HCTColor hct = RGB2HCT(rgb);
+        const RGBColor back = HCT2RGB(hct);
+        maxChannelError = std::max({maxChannelError,
+                                    std::abs(back.red - rgb.red),
+                                    std::abs(back.green - rgb.green),
+                                    std::abs(back.blue - rgb.blue)});
+        const double de = deltaE(hct, RGB2HCT(back));
+        maxDeltaE = std::max(maxDeltaE, de);
+        sumDeltaE += de;
+    }
+    std::printf("  max channel error %d, max dE %.4f, mean dE %.6f\n",
+                maxChannelError, maxDeltaE, sumDeltaE / double(kColorCount));
+    bool ok = gate("round trip channel error", maxChannelError <= kMaxRoundTripChannelError);
+    ok = gate("round trip dE", maxDeltaE <= kMaxRoundTripDeltaE) && ok;
+    return ok;
+}
+
+bool benchConversions() {
+    std::printf("Conversion cost\n");
+    constexpr qsizetype kChunk = 65536;
+    std::vector<RGBColor> rgb(kChunk);
+    std::vector<HCTColor> hct(kChunk);
+    std::vector<HCTColor> reference(kChunk);
+    std::vector<RGBColor> back(kChunk);
+    QElapsedTimer timer;
+    bool batchedMatches = true;
+
+    // RGB2HCT：标量与批量
+    qint64 scalarNs = 0;
+    qint64 batchedNs = 0;
+    for (qint64 base = 0; base < kColorCount; base += kChunk) {
+        for (qsizetype i = 0; i < kChunk; ++i) rgb[i] = colorAt(base + i);
+        timer.start();
+        for (qsizetype i = 0; i < kChunk; ++i) reference[i] = RGB2HCT(rgb[i]);
+        scalarNs += timer.nsecsElapsed();
+
+        timer.start();
+        RGB2HCT(rgb.data(), hct.data(), kChunk);
+        batchedNs += timer.nsecsElapsed();
+        for (qsizetype i = 0; i < kChunk && batchedMatches; ++i) {
+            batchedMatches = reference[i].hue == hct[i].hue
+                        && reference[i].chroma == hct[i].chroma
+                        && reference[i].tone == hct[i].tone;
+        }
+    }
+    report("RGB2HCT scalar", scalarNs, kColorCount);
+    report("RGB2HCT batched (linearize table)", batchedNs, kColorCount);
+
+    // HCT2RGB，以全部颜色的 HCT 为输入
+    qint64 clipNs = 0;
+    qint64 batchedClipNs = 0;
+    qint64 reduceNs = 0;
+    for (qint64 base = 0; base < kColorCount; base += kChunk) {
+        for (qsizetype i = 0; i < kChunk; ++i) rgb[i] = colorAt(base + i);
+        RGB2HCT(rgb.data(), hct.data(), kChunk);
+        timer.start();
+        for (qsizetype i = 0; i < kChunk; ++i) back[i] = HCT2RGB(hct[i]);
+        clipNs += timer.nsecsElapsed();
+        timer.start();
+        HCT2RGB(hct.data(), back.data(), kChunk);
+        batchedClipNs += timer.nsecsElapsed();
+        timer.start();
+        HCT2RGB(hct.data(), back.data(), kChunk, GamutMapping::ReduceChroma);
+        reduceNs += timer.nsecsElapsed();
+        g_sink = g_sink + back[kChunk - 1].red;
+    }
+    report("HCT2RGB scalar (Clip)", clipNs, kColorCount);
+    report("HCT2RGB batched (Clip)", batchedClipNs, kColorCount);
+    report("HCT2RGB batched (ReduceChroma, in gamut)", reduceNs, kColorCount);
+
+    // 高彩度输入：大部分落在色域外，走查表 + 细化路径
+    constexpr int kOutOfGamut = 360 * 101;
+    std::vector<HCTColor> vivid;
+    vivid.reserve(kOutOfGamut);
+    for (int h = 0; h < 360; ++h) {
+        for (int t = 0; t <= 100; ++t) vivid.push_back(HCTColor{h + 0.25, 140.0, double(t)});
+    }
+    std::vector<RGBColor> vividOut(vivid.size());
+    timer.start();
+    HCT2RGB(vivid.data(), vividOut.data(), vivid.size());
+    report("HCT2RGB out of gamut (Clip)", timer.nsecsElapsed(), kOutOfGamut);
+    timer.start();
+    HCT2RGB(vivid.data(), vividOut.data(), vivid.size(), GamutMapping::ReduceChroma);
+    report("HCT2RGB out of gamut (ReduceChroma)", timer.nsecsElapsed(), kOutOfGamut);
+
+    return gate("batched RGB2HCT identical to scalar", batchedMatches);
+}
+
+bool benchPrecisions() {
+    std::printf("Precision variants (batched, all 16.7M colors)\n");
+    constexpr qsizetype kChunk = 65536;
+    std::vector<RGBColor> rgb(kChunk);
+    std::vector<HCTColor> exact(kChunk), fast(kChunk);
+    std::vector<RGBColor> exactBack(kChunk), fastBack(kChunk);
+    QElapsedTimer timer;
+    bool ok = true;
+
+    const struct { const char* name; ColorPrecision precision; } variants[] = {
+        {"Exact", ColorPrecision::Exact},
+        {"Float", ColorPrecision::Float},
+        {"Fixed", ColorPrecision::Fixed},
+    };
+    for (const auto& variant : variants) {
+        qint64 toHctNs = 0;
+        qint64 toRgbNs = 0;
+        int maxChannelError = 0;
+        for (qint64 base = 0; base < kColorCount; base += kChunk) {
+            for (qsizetype i = 0; i < kChunk; ++i) rgb[i] = colorAt(base + i);
+            RGB2HCT(rgb.data(), exact.data(), kChunk);
+            HCT2RGB(exact.data(), exactBack.data(), kChunk);
+
+            timer.start();
+            RGB2HCT(rgb.data(), fast.data(), kChunk, variant.precision);
+            toHctNs += timer.nsecsElapsed();
+            timer.start();
+            HCT2RGB(exact.data(), fastBack.data(), kChunk, GamutMapping::Clip, variant.precision);
+            toRgbNs += timer.nsecsElapsed();
+
+            for (qsizetype i = 0; i < kChunk; ++i) {
+                maxChannelError = std::max({maxChannelError,
+                                            std::abs(fastBack[i].red - exactBack[i].red),
+                                            std::abs(fastBack[i].green - exactBack[i].green),
+                                            std::abs(fastBack[i].blue - exactBack[i].blue)});
+            }
+        }
+        const QByteArray toHct = QByteArray("RGB2HCT ") + variant.name;
+        const QByteArray toRgb = QByteArray("HCT2RGB ") + variant.name;
+        report(toHct.constData(), toHctNs, kColorCount);
+        report(toRgb.constData(), toRgbNs, kColorCount);
+        std::printf("  %-40s %d\n", "max channel error vs Exact", maxChannelError);
+        const QByteArray gateName = QByteArray(variant.name) + " HCT2RGB within bound";
+        ok = gate(gateName.constData(), maxChannelError <= kMaxPrecisionChannelError) && ok;
+    }
+    return ok;
+}
+
+void benchTables() {
+    std::printf("Table-driven paths\n");
+    constexpr int kRounds = 2000;
+    const QWPalette palette(RGBColor(19, 149, 192));
+    const QWToneTable table(palette);
+    QElapsedTimer timer;
+
+    timer.start();
+    for (int i = 0; i < kRounds; ++i) {
+        for (int tone = 0; tone <= 100; ++tone) g_sink = g_sink + palette.getQColor(QWPalette::mainColor, tone).red();
+    }
+    report("QWPalette::getQColor", timer.nsecsElapsed(), qint64(kRounds) * 101);
+
+    timer.start();
+    for (int i = 0; i < kRounds; ++i) {
+        for (int tone = 0; tone <= 100; ++tone) g_sink = g_sink + qRed(table.rgb(QWPalette::mainColor, tone));
+    }
+    report("QWToneTable::rgb", timer.nsecsElapsed(), qint64(kRounds) * 101);
+
+    timer.start();
+    for (int i = 0; i < kRounds; ++i) {
+        for (int tone = 0; tone <= 100; ++tone) g_sink = g_sink + maxChroma(i % 360, tone);
+    }
+    report("maxChroma", timer.nsecsElapsed(), qint64(kRounds) * 101);
+}
+
+void benchPalettes() {
+    std::printf("Palette construction and lookup\n");
+    constexpr int kRounds = 2000;
+    QElapsedTimer timer;
+
+    timer.start();
+    for (int i = 0; i < kRounds; ++i) {
+        const QWPalette palette(RGBColor(i & 0xFF, (i * 7) & 0xFF, (i * 13) & 0xFF));
+        g_sink = g_sink + palette.getHCTColor(QWPalette::mainColor, 40).chroma;
+    }
+    report("QWPalette(RGBColor)", timer.nsecsElapsed(), kRounds);
+
+    const QWPalette palette(RGBColor(19, 149, 192));
+    timer.start();
+    for (int i = 0; i < kRounds / 10; ++i) {
+        const QWToneTable table(palette);
+        g_sink = g_sink + qRed(table.rgb(QWPalette::mainColor, 40));
+    }
+    report("QWToneTable(QWPalette)", timer.nsecsElapsed(), kRounds / 10);
+
+    QWPaletteCache& cache = QWPaletteCache::instance();
+    cache.acquire(QColor(19, 149, 192), 80, 20);
+    timer.start();
+    for (int i = 0; i < kRounds * 10; ++i) {
+        g_sink = g_sink + cache.acquire(QColor(19, 149, 192), 80, 20).palette->getHCTColor(QWPalette::mainColor, 40).hue;
+    }
+    report("QWPaletteCache::acquire (hit)", timer.nsecsElapsed(), kRounds * 10);
+
+    // 逐个色调调用 getQColor 计算对比度，直到找到可读的色调；对比亮度表上的二分查找
+    const auto luminance = [](const QColor& color) {
+        const auto channel = [](int c) {
+            const double v = c / 255.0;
+            return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+        };
+        return 0.2126 * channel(color.red()) + 0.7152 * channel(color.green()) + 0.0722 * channel(color.blue());
+    };
+    timer.start();
+    for (int i = 0; i < kRounds; ++i) {
+        const int background = 50 + i % 50;
+        const double target = luminance(palette.getQColor(QWPalette::neutralColor, background));
+        int tone = background - 1;
+        for (; tone > 0; --tone) {
+            if ((target + 0.05) / (luminance(palette.getQColor(QWPalette::neutralAccent, tone)) + 0.05) >= 4.5) break;
+        }
+        g_sink = g_sink + tone;
+    }
+    report("readable tone, getQColor loop", timer.nsecsElapsed(), kRounds);
+
+    palette.relativeLuminance(QWPalette::mainColor, 0); // 构建亮度表
+    timer.start();
+    for (int i = 0; i < kRounds * 10; ++i) {
+        g_sink = g_sink + palette.toneForContrast(QWPalette::neutralAccent, 50 + i % 50, 4.5, QWPalette::neutralColor);
+    }
+    report("QWPalette::toneForContrast", timer.nsecsElapsed(), kRounds * 10);
+}
+
+void benchExtraction() {
+    std::printf("Seed extraction\n");
+    QImage image(1920, 1080, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            line[x] = qRgb((x * 255) / image.width(), (y * 255) / image.height(), (x + y) & 0xFF);
+        }
+    }
+    constexpr int kRounds = 20;
+    std::vector<HCTColor> colors;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kRounds; ++i) extractSeedColor(image, colors);
+    report("extractSeedColor 1920x1080", timer.nsecsElapsed(), kRounds);
+
+    // 全分辨率：串行与并行直方图
+    SeedExtractionOptions options;
+    options.maxDimension = 0;
+    timer.restart();
+    for (int i = 0; i < kRounds; ++i) extractSeedColor(image, colors, options);
+    report("extractSeedColor full-res serial", timer.nsecsElapsed(), kRounds);
+
+    options.parallel = true;
+    timer.restart();
+    for (int i = 0; i < kRounds; ++i) extractSeedColor(image, colors, options);
+    report("extractSeedColor full-res parallel", timer.nsecsElapsed(), kRounds);
+
+    // 4K RGB888：平滑缩放需要格式转换和缩放两份拷贝，原地采样不需要
+    const QImage rgb888 = image.scaled(3840, 2160).convertToFormat(QImage::Format_RGB888);
+    const struct {
+        SeedSampling sampling;
+        const char* name;
+    } modes[] = {
+        {SeedSampling::Smooth, "extractSeedColor 4K RGB888 smooth"},
+        {SeedSampling::Strided, "extractSeedColor 4K RGB888 strided"},
+        {SeedSampling::Box, "extractSeedColor 4K RGB888 box"},
+    };
+    for (const auto& mode : modes) {
+        SeedExtractionOptions sampled;
+        sampled.sampling = mode.sampling;
+        timer.restart();
+        for (int i = 0; i < kRounds; ++i) extractSeedColor(rgb888, colors, sampled);
+        report(mode.name, timer.nsecsElapsed(), kRounds);
+    }
+
+    // 大尺寸 JPEG：完整解码后提取 vs 解码时缩放
+    QTemporaryDir dir;
+    const QString path = dir.filePath("bench.jpg");
+    if (!dir.isValid() || !image.scaled(8160, 6120).save(path, "JPEG", 90)) {
+        std::printf("  (JPEG plugin unavailable, skipping decode benchmark)\n");
+        return;
+    }
+    constexpr int kDecodeRounds = 3;
+    timer.restart();
+    for (int i = 0; i < kDecodeRounds; ++i) extractSeedColor(QImage(path), colors);
+    report("QImage(path) + extractSeedColor 50MP", timer.nsecsElapsed(), kDecodeRounds);
+
+    timer.restart();
+    for (int i = 0; i < kDecodeRounds; ++i) extractSeedColorFromFile(path, colors);
+    report("extractSeedColorFromFile 50MP", timer.nsecsElapsed(), kDecodeRounds);
+
+    QWSeedCache& cache = QWSeedCache::instance();
+    const QString oldCachePath = cache.filePath();
+    cache.setFilePath(dir.filePath("seedcache.bin"));
+    cache.extractFromFile(path, colors);
+    cache.setFilePath(dir.filePath("seedcache.bin")); // 丢弃内存缓存，测量磁盘命中
+    timer.restart();
+    cache.extractFromFile(path, colors);
+    report("QWSeedCache disk hit 50MP", timer.nsecsElapsed(), 1);
+    timer.restart();
+    for (int i = 0; i < kRounds; ++i) cache.extractFromFile(path, colors);
+    report("QWSeedCache memory hit 50MP", timer.nsecsElapsed(), kRounds);
+    cache.setFilePath(oldCachePath);
+}
+
+void benchQuantizers() {
+    std::printf("Seed quantizers (1080p noisy photo, strided 256)\n");
+    // 两块带 ±12 噪声的颜色：种子越接近真实颜色越好
+    QImage photo(1920, 1080, QImage::Format_RGB32);
+    const RGBColor base[] = {RGBColor(100, 150, 200), RGBColor(220, 120, 40)};
+    quint32 seed = 7;
+    for (int y = 0; y < photo.height(); ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(photo.scanLine(y));
+        for (int x = 0; x < photo.width(); ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const RGBColor& c = base[x < photo.width() * 2 / 3 ? 0 : 1];
+            const auto noisy = [seed](int value, int shift) {
+                return std::clamp(value + static_cast<int>((seed >> shift) % 25) - 12, 0, 255);
+            };
+            line[x] = qRgb(noisy(c.red, 8), noisy(c.green, 16), noisy(c.blue, 24));
+        }
+    }
+    const HCTColor truth[] = {RGB2HCT(base[0]), RGB2HCT(base[1])};
+
+    constexpr int kRounds = 20;
+    std::vector<HCTColor> colors;
+    for (int bits = 4; bits <= 6; ++bits) {
+        for (const SeedQuantizer quantizer : {SeedQuantizer::Histogram, SeedQuantizer::KMeans}) {
+            SeedExtractionOptions options;
+            options.sampling = SeedSampling::Strided;
+            options.binBits = bits;
+            options.quantizer = quantizer;
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < kRounds; ++i) extractSeedColor(photo, colors, options);
+            char name[64];
+            std::snprintf(name, sizeof(name), "%d-bit %s", bits,
+                quantizer == SeedQuantizer::KMeans ? "kmeans" : "histogram");
+            report(name, timer.nsecsElapsed(), kRounds);
+
+            // 每种真实颜色与最接近的种子之间的 ΔE
+            double worst = 0.0;
+            for (const HCTColor& color : truth) {
+                double best = 1e9;
+                for (const HCTColor& c : colors) best = std::min(best, deltaE(color, c));
+                worst = std::max(worst, best);
+            }
+            std::printf("    seeds %zu, worst seed dE %.2f\n", colors.size(), worst);
+        }
+    }
+}
+
+void benchBatch() {
+    std::printf("Batch seed extraction\n");
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        return;
+    }
+    // 媒体库缩略图：200 张 512x512 JPEG（没有 JPEG 插件时使用 PNG）
+    const char* format = QImageReader::supportedImageFormats().contains("jpeg") ? "jpg" : "png";
+    constexpr int kImages = 200;
+    QStringList paths;
+    QImage thumb(512, 512, QImage::Format_RGB32);
+    for (int i = 0; i < kImages; ++i) {
+        for (int y = 0; y < thumb.height(); ++y) {
+            QRgb* line = reinterpret_cast<QRgb*>(thumb.scanLine(y));
+            for (int x = 0; x < thumb.width(); ++x) {
+                line[x] = qRgb((x + i * 7) & 0xFF, (y + i * 13) & 0xFF, (x ^ y ^ i) & 0xFF);
+            }
+        }
+        const QString path = dir.filePath(QString("thumb%1.%2").arg(i).arg(format));
+        thumb.save(path);
+        paths.append(path);
+    }
+
+    std::vector<HCTColor> colors;
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString& path : paths) extractSeedColorFromFile(path, colors);
+    const qint64 sequential = timer.nsecsElapsed();
+    report("extractSeedColorFromFile loop, per image", sequential, kImages);
+
+    QWSeedExtractor extractor;
+    extractor.setUseCache(false);
+    timer.restart();
+    extractor.extractAll(paths, [](const QWSeedExtractor::Result&) {});
+    const qint64 batched = timer.nsecsElapsed();
+    report("QWSeedExtractor::extractAll, per image", batched, kImages);
+    std::printf("  throughput: %.0f -> %.0f images/s (%d workers)\n",
+        kImages * 1e9 / double(sequential), kImages * 1e9 / double(batched), extractor.maxWorkers());
+}
+
+void benchTracker() {
+    std::printf("Per-frame seed tracking\n");
+    // 1080p 视频帧：渐变背景上移动的物体
+    constexpr int kFrames = 16;
+    std::vector<QImage> frames;
+    for (int f = 0; f < kFrames; ++f) {
+        QImage frame(1920, 1080, QImage::Format_ARGB32);
+        for (int y = 0; y < frame.height(); ++y) {
+            QRgb* line = reinterpret_cast<QRgb*>(frame.scanLine(y));
+            for (int x = 0; x < frame.width(); ++x) {
+                const bool object = x >= 100 + f * 50 && x < 400 + f * 50 && y >= 300 && y < 600;
+                line[x] = object ? qRgb(230, 120, 20) : qRgb(40 + (y * 40) / 1080, 90, 200);
+            }
+        }
+        frames.push_back(frame);
+    }
+
+    constexpr int kRounds = 160;
+    std::vector<HCTColor> colors;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kRounds; ++i) extractSeedColor(frames[i % kFrames], colors);
+    report("extractSeedColor per frame 1080p", timer.nsecsElapsed(), kRounds);
+
+    QWSeedTracker tracker;
+    tracker.update(frames[0]);
+    timer.restart();
+    for (int i = 0; i < kRounds * 10; ++i) tracker.update(frames[i % kFrames]);
+    report("QWSeedTracker::update per frame 1080p", timer.nsecsElapsed(), kRounds * 10);
+    std::printf("  rescored %d of %d frames\n", tracker.scoringCount(), tracker.frameCount());
+}
+
+void benchIconTint() {
+    std::printf("Icon tinting\n");
+    // 切换深浅色时重新着色 300 个 24px@2x 的单色图标
+    constexpr int kIcons = 300;
+    std::vector<QImage> masks;
+    for (int i = 0; i < kIcons; ++i) {
+        QImage mask(48, 48, QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y < mask.height(); ++y) {
+            QRgb* line = reinterpret_cast<QRgb*>(mask.scanLine(y));
+            for (int x = 0; x < mask.width(); ++x) {
+                line[x] = qPremultiply(qRgba(0, 0, 0, ((x + i) * (y + 3)) & 0xFF));
+            }
+        }
+        masks.push_back(mask);
+    }
+    const QColor color(19, 149, 192);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (const QImage& mask : masks) {
+        // 常见的手写实现：逐像素 pixel / setPixel
+        QImage out(mask.size(), QImage::Format_ARGB32);
+        for (int y = 0; y < mask.height(); ++y) {
+            for (int x = 0; x < mask.width(); ++x) {
+                out.setPixel(x, y, qRgba(color.red(), color.green(), color.blue(), qAlpha(mask.pixel(x, y))));
+            }
+        }
+        g_sink += out.constScanLine(0)[0];
+    }
+    report("pixel/setPixel loop, per icon", timer.nsecsElapsed(), kIcons);
+
+    timer.restart();
+    for (const QImage& mask : masks) {
+        g_sink += QWIconTinter::tinted(mask, color).constScanLine(0)[0];
+    }
+    report("QWIconTinter::tinted, per icon", timer.nsecsElapsed(), kIcons);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    bool ok = benchRoundTrip();
+    ok = benchConversions() && ok;
+    ok = benchPrecisions() && ok;
+    benchTables();
+    benchPalettes();
+    benchExtraction();
+    benchQuantizers();
+    benchBatch();
+    benchTracker();
+    benchIconTint();
+
+    std::printf("%s\n", ok ? "All accuracy gates passed." : "Accuracy gates FAILED.");
+    return ok ? 0 : 1;
+}
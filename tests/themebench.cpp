@@ -0,0 +1,343 @@
+// QtWin/tests/themebench.cpp
+//
+// 主题切换基准：在无界面环境（QT_QPA_PLATFORM=offscreen）中构建带有指定规模
+// 控件树的 QWWindow，测量 setSeedColor、setLightTone/setDarkTone、setMaterial
+// 与 QWApplication::toggleDarkMode 从调用到调色板传播、重绘完成的耗时与内存分配次数，
+// 输出百分位数，并可写出 JSON 供 CI 跟踪回归。
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGridLayout>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include <QtWin/QWApplication.h>
+#include <QtWin/QWWindow.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// 分配计数：替换全局 operator new，统计本程序代码（包括内联进来的 Qt 模板与头文件代码）中的分配。
+// 在 Linux 等共享全局符号的平台上 Qt 库内部的分配也会计入；Windows（MSVC / MinGW）上
+// Qt DLL 使用自己链接的 operator new，不会计入。对齐（std::align_val_t）版本没有替换，同样不计入。
+// ---------------------------------------------------------------------------
+
+namespace {
+std::atomic<quint64> g_allocations{0};
+std::atomic<quint64> g_allocatedBytes{0};
+
+void* countedAlloc(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+using namespace QtWin;
+
+namespace {
+
+FILE* g_report = stdout; // JSON 写到标准输出时，文本报告改写到标准错误
+
+struct Config {
+    int widgets = 1000;   // 每个窗口的控件数
+    int fanout = 10;      // 每个容器的子控件数
+    int windows = 1;      // 同时打开的窗口数
+    int iterations = 100; // 每个场景的测量次数
+    int warmup = 5;       // 不计入结果的预热次数
+};
+
+struct Sample {
+    qint64 nsecs;
+    quint64 allocations;
+    quint64 bytes;
+};
+
+struct Stats {
+    QString name;
+    std::vector<Sample> samples;
+    QWWindow::PaintStats paint; // 所有窗口计时期间的绘制统计之和
+};
+
+/** 按 fanout 递归构建控件树，直到达到 remaining 个控件。 */
+void populate(QWidget* parent, int& remaining, int fanout, int depth) {
+    auto* layout = new QGridLayout(parent);
+    layout->setContentsMargins(2, 2, 2, 2);
+    for (int i = 0; i < fanout && remaining > 0; ++i) {
+        QWidget* child = nullptr;
+        if (depth < 3 && remaining > fanout && i % 3 == 0) {
+            child = new QWidget(parent);
+            --remaining;
+            populate(child, remaining, fanout, depth + 1);
+        } else {
+            switch (i % 3) {
+                case 0: child = new QLabel(QStringLiteral("Label %1").arg(remaining), parent); break;
+                case 1: child = new QPushButton(QStringLiteral("Button"), parent); break;
+                default: child = new QLineEdit(parent); break;
+            }
+            --remaining;
+        }
+        layout->addWidget(child, i / 4, i % 4);
+    }
+}
+
+QWWindow* createWindow(const Config& config) {
+    auto* window = new QWWindow;
+    auto* central = new QWidget;
+    int remaining = config.widgets;
+    while (remaining > 0) {
+        // 顶层容器不断追加，直到控件数达到要求
+        auto* group = new QWidget(central);
+        --remaining;
+        populate(group, remaining, config.fanout, 0);
+        if (!central->layout()) {
+            new QVBoxLayout(central);
+        }
+        central->layout()->addWidget(group);
+    }
+    window->setCentralWidget(central);
+    window->setMaterial(QWWindow::Default);
+    window->show();
+    return window;
+}
+
+/** 处理完所有待处理的事件：延迟应用的主题、PaletteChange 与重绘。 */
+void settle() {
+    QCoreApplication::sendPostedEvents();
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    QCoreApplication::sendPostedEvents();
+}
+
+Stats measure(const QString& name, const Config& config, const std::vector<QWWindow*>& windows,
+              const std::function<void(int)>& action) {
+    Stats stats{name, {}, {}};
+    stats.samples.reserve(config.iterations);
+    if (config.warmup == 0) {
+        for (QWWindow* window : windows) window->resetPaintStats();
+    }
+    for (int i = 0; i < config.warmup + config.iterations; ++i) {
+        settle();
+        const quint64 allocations = g_allocations.load();
+        const quint64 bytes = g_allocatedBytes.load();
+        QElapsedTimer timer;
+        timer.start();
+        action(i);
+        settle();
+        const qint64 elapsed = timer.nsecsElapsed();
+        if (i >= config.warmup) {
+            stats.samples.push_back({elapsed, g_allocations.load() - allocations, g_allocatedBytes.load() - bytes});
+        }
+        if (i + 1 == config.warmup) {
+            for (QWWindow* window : windows) window->resetPaintStats();
+        }
+    }
+    for (QWWindow* window : windows) {
+        const QWWindow::PaintStats paint = window->paintStats();
+        stats.paint.paints += paint.paints;
+        stats.paint.totalNsecs += paint.totalNsecs;
+        stats.paint.maxNsecs = std::max(stats.paint.maxNsecs, paint.maxNsecs);
+        stats.paint.totalArea += paint.totalArea;
+    }
+    return stats;
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    if (values.empty()) return 0.0;
+    const double rank = p / 100.0 * (values.size() - 1);
+    const size_t lo = static_cast<size_t>(rank);
+    const size_t hi = std::min(lo + 1, values.size() - 1);
+    return values[lo] + (values[hi] - values[lo]) * (rank - lo);
+}
+
+QJsonObject summarize(const Stats& stats) {
+    std::vector<double> micros;
+    std::vector<double> allocations;
+    double bytes = 0.0;
+    for (const Sample& sample : stats.samples) {
+        micros.push_back(sample.nsecs / 1000.0);
+        allocations.push_back(double(sample.allocations));
+        bytes += double(sample.bytes);
+    }
+    double mean = 0.0;
+    for (double v : micros) mean += v;
+    mean /= std::max<size_t>(1, micros.size());
+
+    QJsonObject time;
+    time["mean"] = mean;
+    time["min"] = percentile(micros, 0);
+    time["p50"] = percentile(micros, 50);
+    time["p90"] = percentile(micros, 90);
+    time["p99"] = percentile(micros, 99);
+    time["max"] = percentile(micros, 100);
+
+    QJsonObject allocs;
+    allocs["p50"] = percentile(allocations, 50);
+    allocs["max"] = percentile(allocations, 100);
+    allocs["meanBytes"] = bytes / std::max<size_t>(1, stats.samples.size());
+
+    // 窗口自身 paintEvent 的开销，不包括子控件
+    const double paints = double(stats.paint.paints);
+    QJsonObject paint;
+    paint["count"] = paints;
+    paint["meanUs"] = paints > 0 ? stats.paint.totalNsecs / 1000.0 / paints : 0.0;
+    paint["maxUs"] = stats.paint.maxNsecs / 1000.0;
+    paint["meanArea"] = paints > 0 ? double(stats.paint.totalArea) / paints : 0.0;
+
+    QJsonObject result;
+    result["name"] = stats.name;
+    result["samples"] = int(stats.samples.size());
+    result["timeUs"] = time;
+    result["allocations"] = allocs;
+    result["windowPaint"] = paint;
+
+    std::fprintf(g_report, "  %-24s p50 %9.1f us  p90 %9.1f us  p99 %9.1f us  max %9.1f us  allocs p50 %7.0f"
+                "  paints %5.0f (%.1f us)\n",
+                qPrintable(stats.name), time["p50"].toDouble(), time["p90"].toDouble(),
+                time["p99"].toDouble(), time["max"].toDouble(), allocs["p50"].toDouble(),
+                paints, paint["meanUs"].toDouble());
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // CI 机器上没有显示服务器；显式指定了平台时尊重调用方的选择
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QWApplication app(argc, argv, "QtWin", "QtWinThemeBench", "0.0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures theme-switch cost of QWWindow.");
+    parser.addHelpOption();
+    const QCommandLineOption widgetsOption("widgets", "Widgets per window.", "count", "1000");
+    const QCommandLineOption fanoutOption("fanout", "Children per container widget.", "count", "10");
+    const QCommandLineOption windowsOption("windows", "Number of open windows.", "count", "1");
+    const QCommandLineOption iterationsOption("iterations", "Measured iterations per scenario.", "count", "100");
+    const QCommandLineOption warmupOption("warmup", "Unmeasured warm-up iterations.", "count", "5");
+    const QCommandLineOption jsonOption("json", "Write results as JSON to file ('-' for stdout).", "file");
+    parser.addOptions({widgetsOption, fanoutOption, windowsOption, iterationsOption, warmupOption, jsonOption});
+    parser.process(app);
+
+    Config config;
+    config.widgets = std::max(1, parser.value(widgetsOption).toInt());
+    config.fanout = std::max(2, parser.value(fanoutOption).toInt());
+    config.windows = std::max(1, parser.value(windowsOption).toInt());
+    config.iterations = std::max(1, parser.value(iterationsOption).toInt());
+    config.warmup = std::max(0, parser.value(warmupOption).toInt());
+
+    if (parser.value(jsonOption) == "-") {
+        g_report = stderr;
+    }
+    std::fprintf(g_report, "Theme switch: %d window(s) x %d widgets, %d iterations, platform %s\n",
+                config.windows, config.widgets, config.iterations, qPrintable(QGuiApplication::platformName()));
+
+    std::vector<QWWindow*> windows;
+    for (int i = 0; i < config.windows; ++i) {
+        windows.push_back(createWindow(config));
+    }
+    settle();
+
+    // 启动各阶段耗时，firstWindow 为首个窗口显示的时间
+    QJsonArray startup;
+    std::fprintf(g_report, "  %-24s", "startup");
+    for (const QWApplication::StartupPhase& phase : app.startupPhases()) {
+        QJsonObject entry;
+        entry["name"] = phase.name;
+        entry["timeUs"] = phase.nsecs / 1000.0;
+        entry["worker"] = phase.worker;
+        startup.append(entry);
+        std::fprintf(g_report, " %s %.1f us%s", qPrintable(phase.name), phase.nsecs / 1000.0, phase.worker ? " [worker]" : "");
+    }
+    std::fprintf(g_report, "\n");
+
+    const auto forEachWindow = [&windows](const std::function<void(QWWindow*)>& f) {
+        for (QWWindow* window : windows) f(window);
+    };
+
+    std::vector<Stats> results;
+    results.push_back(measure("setSeedColor", config, windows, [&](int i) {
+        const QColor seed = (i % 2) ? QColor(19, 149, 192) : QColor(200, 80, 40);
+        forEachWindow([&](QWWindow* w) { w->setSeedColor(seed); });
+    }));
+    results.push_back(measure("setLightTone+setDarkTone", config, windows, [&](int i) {
+        forEachWindow([&](QWWindow* w) {
+            w->setLightTone((i % 2) ? 80 : 85);
+            w->setDarkTone((i % 2) ? 20 : 15);
+        });
+    }));
+    results.push_back(measure("setMaterial", config, windows, [&](int i) {
+        const auto material = (i % 2) ? QWWindow::Default : QWWindow::Mica;
+        forEachWindow([&](QWWindow* w) { w->setMaterial(material); });
+    }));
+    results.push_back(measure("toggleDarkMode", config, windows, [&](int) {
+        app.toggleDarkMode();
+    }));
+
+    QJsonArray scenarios;
+    for (const Stats& stats : results) {
+        scenarios.append(summarize(stats));
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject configJson;
+        configJson["widgets"] = config.widgets;
+        configJson["fanout"] = config.fanout;
+        configJson["windows"] = config.windows;
+        configJson["iterations"] = config.iterations;
+        configJson["warmup"] = config.warmup;
+        configJson["platform"] = QGuiApplication::platformName();
+
+        QJsonObject root;
+        root["benchmark"] = "QtWinThemeBench";
+        root["config"] = configJson;
+        root["startup"] = startup;
+        root["scenarios"] = scenarios;
+        const QByteArray json = QJsonDocument(root).toJson();
+
+        const QString path = parser.value(jsonOption);
+        if (path == "-") {
+            std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        } else {
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+                std::fprintf(stderr, "Could not write %s\n", qPrintable(path));
+                return 1;
+            }
+        }
+    }
+
+    qDeleteAll(windows);
+    return 0;
+}
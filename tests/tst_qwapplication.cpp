@@ -0,0 +1,118 @@
+// QtWin/tests/tst_qwapplication.cpp
+//
+// QWApplication 启动测试。每个进程只能有一个 QWApplication，因此同一个程序由 ctest
+// 以三种初始化方式各运行一次，方式由环境变量 QTWIN_TEST_INIT_MODE 指定（默认 Sequential）。
+
+#include <QtTest>
+#include <QMetaEnum>
+#include <QStandardPaths>
+
+#include <QtWin/QWApplication.h>
+#include <QtWin/QWThemeManager.h>
+#include <QtWin/QWThemeSnapshot.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+using namespace QtWin;
+
+class TestQWApplication : public QObject {
+    Q_OBJECT
+
+private slots:
+    void settingsFromWorkerThread();
+    void startupPhasesAreRecorded();
+    void themeSnapshotIsSaved();
+};
+
+void TestQWApplication::settingsFromWorkerThread() {
+    QWApplication* app = QWApplication::instance();
+
+    // 其他线程只等待 GUI 线程完成初始化；Concurrent / Deferred 模式下在事件循环中完成
+    std::atomic<QWSettings*> settings{nullptr};
+    std::atomic<bool> snapshotRead{false};
+    std::atomic<bool> done{false};
+    std::thread worker([&]() {
+        settings = app->settings();
+        app->themeSnapshot();
+        snapshotRead = true;
+        done = true;
+    });
+    QTRY_VERIFY(done.load());
+    worker.join();
+
+    QVERIFY(snapshotRead.load());
+    QVERIFY(settings.load() != nullptr);
+    QCOMPARE(settings.load(), app->settings());
+    // 设置对象由 GUI 线程接管
+    QCOMPARE(settings.load()->thread(), app->thread());
+    QCOMPARE(settings.load()->parent(), static_cast<QObject*>(app));
+}
+
+void TestQWApplication::startupPhasesAreRecorded() {
+    QWApplication* app = QWApplication::instance();
+    QVERIFY(app->settings() != nullptr);
+
+    QStringList names;
+    const QList<QWApplication::StartupPhase> phases = app->startupPhases();
+    for (const QWApplication::StartupPhase& phase : phases) {
+        names << phase.name;
+        QVERIFY(phase.startNsecs >= 0);
+        QVERIFY(phase.nsecs >= 0);
+        // 只有 Concurrent 模式在工作线程中初始化日志与设置
+        const bool workerPhase = phase.name == "paths" || phase.name == "logger" || phase.name == "settings";
+        QCOMPARE(phase.worker, workerPhase && app->initMode() == QWApplication::Concurrent);
+    }
+    for (const char* name : {"paths", "logger", "settings", "themeManager", "themeSnapshot"}) {
+        QCOMPARE(names.count(QLatin1String(name)), 1);
+    }
+    QCOMPARE(names.contains("wait"), app->initMode() == QWApplication::Concurrent);
+}
+
+void TestQWApplication::themeSnapshotIsSaved() {
+    QWApplication* app = QWApplication::instance();
+    const QColor seed(201, 82, 40);
+    const QWThemeSnapshot snapshot = QWThemeSnapshot::capture(seed, 80, 20, 4.5, app->themeManager());
+    app->setThemeSnapshot(snapshot);
+
+    QVERIFY(app->themeSnapshot().isValid());
+    QVERIFY(app->themeSnapshot().matches(seed, 80, 20, 4.5));
+    const QWThemeSnapshot saved = QWThemeSnapshot::load(app->settings());
+    QVERIFY(saved.matches(seed, 80, 20, 4.5));
+    QCOMPARE(saved.palette(true), snapshot.palette(true));
+
+    // 其他线程读到的是同一份快照
+    std::atomic<bool> matches{false};
+    std::thread worker([&]() { matches = app->themeSnapshot().matches(seed, 80, 20, 4.5); });
+    worker.join();
+    QVERIFY(matches.load());
+
+    app->setThemeSnapshot(QWThemeSnapshot());
+    QVERIFY(!QWThemeSnapshot::load(app->settings()).isValid());
+}
+
+int main(int argc, char* argv[]) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QWApplication::InitMode mode = QWApplication::Sequential;
+    const QByteArray modeName = qgetenv("QTWIN_TEST_INIT_MODE");
+    if (!modeName.isEmpty()) {
+        bool ok = false;
+        const int value = QMetaEnum::fromType<QWApplication::InitMode>().keyToValue(modeName.constData(), &ok);
+        if (!ok) {
+            std::fprintf(stderr, "Unknown QTWIN_TEST_INIT_MODE: %s\n", modeName.constData());
+            return 2;
+        }
+        mode = QWApplication::InitMode(value);
+    }
+    // 设置与日志写到测试专用目录；每种方式使用自己的应用名，ctest 并行运行时互不影响
+    QStandardPaths::setTestModeEnabled(true);
+    QWApplication app(argc, argv, "QtWin", "QtWinApplicationTests" + QString::fromLatin1(modeName),
+                      "0.0.1", false, mode);
+    TestQWApplication test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_qwapplication.moc"
@@ -0,0 +1,1068 @@
+// QtWin/tests/tst_qwpalette.cpp
+
+#include <QtTest>
+#include <QBuffer>
+#include <QImage>
+#include <QTemporaryDir>
+
+#include <QtWin/QWIconTinter.h>
+#include <QtWin/QWPalette.h>
+#include <QtWin/QWPaletteCache.h>
+#include <QtWin/QWSeedCache.h>
+#include <QtWin/QWSeedExtractor.h>
+#include <QtWin/QWSeedTracker.h>
+#include <QtWin/QWStyleSheet.h>
+#include <QtWin/QWThemeManager.h>
+#include <QtWin/QWThemeSnapshot.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace QtWin;
+
+namespace {
+
+// 精度门限：任何新的快速路径都必须满足这些条件，否则测试失败
+constexpr double kMaxRoundTripDeltaE = 0.5;
+constexpr int kMaxRoundTripChannelError = 1;
+constexpr double kMaxGamutToneShift = 0.5;
+constexpr double kMaxGamutHueShift = 2.0; // 输出彩度 >= 30 时
+constexpr int kMaxPrecisionChannelError = 1; // Float / Fixed 相对 Exact
+constexpr double kMaxPrecisionDeltaE = 0.5;
+
+/** 由 HCT（即 CIELCh）计算两个颜色之间的 CIE76 ΔE。 */
+double deltaE(const HCTColor& x, const HCTColor& y) {
+    const double ax = x.chroma * std::cos(x.hue * M_PI / 180.0);
+    const double bx = x.chroma * std::sin(x.hue * M_PI / 180.0);
+    const double ay = y.chroma * std::cos(y.hue * M_PI / 180.0);
+    const double by = y.chroma * std::sin(y.hue * M_PI / 180.0);
+    const double dl = x.tone - y.tone;
+    return std::sqrt(dl * dl + (ax - ay) * (ax - ay) + (bx - by) * (bx - by));
+}
+
+double hueDistance(double a, double b) {
+    const double d = std::fabs(a - b);
+    return d > 180.0 ? 360.0 - d : d;
+}
+
+/** WCAG 相对亮度，逐个分量线性化。 */
+double wcagLuminance(const QColor& color) {
+    const auto channel = [](int c) {
+        const double v = c / 255.0;
+        return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+    };
+    return 0.2126 * channel(color.red()) + 0.7152 * channel(color.green()) + 0.0722 * channel(color.blue());
+}
+
+/** 左侧为带噪声的蓝色、右侧为带噪声的橙色的照片，噪声在每通道 ±12 以内。 */
+QImage noisyPhoto(int width, int height) {
+    QImage image(width, height, QImage::Format_RGB32);
+    quint32 seed = 7;
+    for (int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const int base[3] = {x < width * 2 / 3 ? 100 : 220, x < width * 2 / 3 ? 150 : 120, x < width * 2 / 3 ? 200 : 40};
+            int channel[3];
+            for (int i = 0; i < 3; ++i) {
+                channel[i] = std::clamp(base[i] + static_cast<int>((seed >> (8 * i + 8)) % 25) - 12, 0, 255);
+            }
+            line[x] = qRgb(channel[0], channel[1], channel[2]);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+class TestQWPalette : public QObject {
+    Q_OBJECT
+
+private slots:
+    void roundTripExhaustive();
+    void batchedMatchesScalar();
+    void precisionVariantsWithinBounds_data();
+    void precisionVariantsWithinBounds();
+    void gamutMappingKeepsHueAndTone();
+    void maxChromaTableIsAccurate();
+    void toneTableMatchesPalette();
+    void paletteCacheSharesEntries();
+    void paletteCacheEvictsLeastRecentlyUsed();
+    void extractSeedColorFindsDominantHue();
+    void extractSeedColorFallsBackToGray();
+    void parallelExtractionMatchesSerial();
+    void quantizerHonorsAlphaAndRowTails();
+    void inPlaceSamplingMatchesLegacy_data();
+    void inPlaceSamplingMatchesLegacy();
+    void extractSeedColorFromFileAndDevice();
+    void asyncExtractionCoalescesRequests();
+    void seedCachePersistsResults();
+    void batchExtractorMatchesSingleFile();
+    void seedTrackerFollowsFrames();
+    void quantizerDepthsAreDeterministic_data();
+    void quantizerDepthsAreDeterministic();
+    void clusteringRefinesNoisySeeds();
+    void iconTintMatchesReference();
+    void themeManagerSharesPalettes();
+    void changedRolesReportsDifferences();
+    void themeTransitionInterpolatesInHct();
+    void styleSheetTemplateRendersAndCaches();
+    void toneForContrastMatchesExhaustiveSearch();
+    void themeManagerEnforcesTextContrast();
+    void themeSnapshotRoundTrips();
+};
+
+void TestQWPalette::roundTripExhaustive() {
+    // 全部 16.7M 个 sRGB 颜色：RGB -> HCT -> RGB -> HCT
+    int maxChannelError = 0;
+    double maxDeltaE = 0.0;
+    double sumDeltaE = 0.0;
+    for (int r = 0; r < 256; ++r) {
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b) {
+                const HCTColor hct = RGB2HCT(RGBColor(r, g, b));
+                const RGBColor back = HCT2RGB(hct);
+                maxChannelError = std::max({maxChannelError,
+                                            std::abs(back.red - r),
+                                            std::abs(back.green - g),
+                                            std::abs(back.blue - b)});
+                const double de = deltaE(hct, RGB2HCT(back));
+                maxDeltaE = std::max(maxDeltaE, de);
+                sumDeltaE += de;
+            }
+        }
+    }
+    qInfo("round trip: max channel error %d, max dE %.4f, mean dE %.6f",
+        maxChannelError, maxDeltaE, sumDeltaE / (256.0 * 256.0 * 256.0));
+    QVERIFY(maxChannelError <= kMaxRoundTripChannelError);
+    QVERIFY(maxDeltaE <= kMaxRoundTripDeltaE);
+}
+
+void TestQWPalette::batchedMatchesScalar() {
+    std::vector<RGBColor> rgb;
+    rgb.reserve(256 * 256);
+    std::vector<HCTColor> hct(256 * 256);
+    std::vector<RGBColor> back(256 * 256);
+    for (int r = 0; r < 256; ++r) {
+        rgb.clear();
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b) {
+                rgb.emplace_back(r, g, b);
+            }
+        }
+        RGB2HCT(rgb.data(), hct.data(), rgb.size());
+        HCT2RGB(hct.data(), back.data(), hct.size());
+        for (size_t i = 0; i < rgb.size(); ++i) {
+            const HCTColor ref = RGB2HCT(rgb[i]);
+            if (ref.hue != hct[i].hue || ref.chroma != hct[i].chroma || ref.tone != hct[i].tone) {
+                QFAIL(qPrintable(QString("batched RGB2HCT differs at (%1,%2,%3)")
+                                    .arg(rgb[i].red).arg(rgb[i].green).arg(rgb[i].blue)));
+            }
+            if (back[i].red != rgb[i].red || back[i].green != rgb[i].green || back[i].blue != rgb[i].blue) {
+                QFAIL("batched HCT2RGB round trip differs from the input");
+            }
+        }
+    }
+}
+
+void TestQWPalette::precisionVariantsWithinBounds_data() {
+    QTest::addColumn<int>("precision");
+    QTest::newRow("Float") << static_cast<int>(ColorPrecision::Float);
+    QTest::newRow("Fixed") << static_cast<int>(ColorPrecision::Fixed);
+}
+
+void TestQWPalette::precisionVariantsWithinBounds() {
+    QFETCH(int, precision);
+    const auto variant = static_cast<ColorPrecision>(precision);
+
+    constexpr qsizetype kChunk = 256 * 256;
+    std::vector<RGBColor> rgb;
+    rgb.reserve(kChunk);
+    std::vector<HCTColor> exact(kChunk), fast(kChunk);
+    std::vector<RGBColor> exactBack(kChunk), fastBack(kChunk), roundTrip(kChunk);
+    int maxChannelError = 0;
+    int maxRoundTripError = 0;
+    double maxDeltaE = 0.0;
+    for (int r = 0; r < 256; ++r) {
+        rgb.clear();
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b) {
+                rgb.emplace_back(r, g, b);
+            }
+        }
+        RGB2HCT(rgb.data(), exact.data(), kChunk);
+        RGB2HCT(rgb.data(), fast.data(), kChunk, variant);
+        HCT2RGB(exact.data(), exactBack.data(), kChunk);
+        HCT2RGB(exact.data(), fastBack.data(), kChunk, GamutMapping::Clip, variant);
+        HCT2RGB(fast.data(), roundTrip.data(), kChunk, GamutMapping::Clip, variant);
+        for (qsizetype i = 0; i < kChunk; ++i) {
+            maxChannelError = std::max({maxChannelError,
+                                        std::abs(fastBack[i].red - exactBack[i].red),
+                                        std::abs(fastBack[i].green - exactBack[i].green),
+                                        std::abs(fastBack[i].blue - exactBack[i].blue)});
+            maxRoundTripError = std::max({maxRoundTripError,
+                                        std::abs(roundTrip[i].red - rgb[i].red),
+                                        std::abs(roundTrip[i].green - rgb[i].green),
+                                        std::abs(roundTrip[i].blue - rgb[i].blue)});
+            maxDeltaE = std::max(maxDeltaE, deltaE(exact[i], fast[i]));
+        }
+    }
+    qInfo("HCT2RGB vs Exact: max channel error %d, round trip error %d, RGB2HCT max dE %.4f",
+        maxChannelError, maxRoundTripError, maxDeltaE);
+    QVERIFY(maxChannelError <= kMaxPrecisionChannelError);
+    QVERIFY(maxRoundTripError <= kMaxRoundTripChannelError);
+    QVERIFY(maxDeltaE <= kMaxPrecisionDeltaE);
+}
+
+void TestQWPalette::gamutMappingKeepsHueAndTone() {
+    double maxToneShift = 0.0;
+    double maxHueShift = 0.0;
+    for (int hue = 0; hue < 360; ++hue) {
+        for (int tone = 5; tone <= 95; ++tone) {
+            for (double chroma : {40.0, 80.0, 150.0}) {
+                const RGBColor rgb = HCT2RGB(HCTColor{double(hue), chroma, double(tone)},
+                                            GamutMapping::ReduceChroma);
+                const HCTColor out = RGB2HCT(rgb);
+                maxToneShift = std::max(maxToneShift, std::fabs(out.tone - tone));
+                if (out.chroma >= 30.0) {
+                    maxHueShift = std::max(maxHueShift, hueDistance(out.hue, hue));
+                }
+                // 色域内的颜色不受映射方式影响
+                if (chroma <= maxChroma(hue, tone) * 0.95) {
+                    const RGBColor clipped = HCT2RGB(HCTColor{double(hue), chroma, double(tone)});
+                    QCOMPARE(rgb.red, clipped.red);
+                    QCOMPARE(rgb.green, clipped.green);
+                    QCOMPARE(rgb.blue, clipped.blue);
+                }
+            }
+        }
+    }
+    qInfo("gamut mapping: max tone shift %.3f, max hue shift %.3f", maxToneShift, maxHueShift);
+    QVERIFY(maxToneShift <= kMaxGamutToneShift);
+    QVERIFY(maxHueShift <= kMaxGamutHueShift);
+}
+
+void TestQWPalette::maxChromaTableIsAccurate() {
+    // 插值得到的边界与 ReduceChroma 最终解出的彩度相差不大
+    for (int hue = 0; hue < 360; hue += 7) {
+        for (int tone = 10; tone <= 90; tone += 10) {
+            const double estimate = maxChroma(hue + 0.5, tone);
+            const HCTColor out = RGB2HCT(HCT2RGB(HCTColor{hue + 0.5, 200.0, double(tone)},
+                                                GamutMapping::ReduceChroma));
+            QVERIFY2(std::fabs(out.chroma - estimate) < 3.0,
+                    qPrintable(QString("hue %1 tone %2: table %3, solved %4")
+                                .arg(hue).arg(tone).arg(estimate).arg(out.chroma)));
+        }
+    }
+    QCOMPARE(maxChroma(120.0, 0.0), 0.0);
+    QCOMPARE(maxChroma(120.0, 100.0), 0.0);
+}
+
+void TestQWPalette::toneTableMatchesPalette() {
+    const QWPalette palette(RGBColor(19, 149, 192));
+    const QWToneTable table(palette);
+    for (int role = 0; role < QWToneTable::kRoleCount; ++role) {
+        const auto color = static_cast<QWPalette::QWColor>(role);
+        for (int tone = 0; tone <= 100; ++tone) {
+            QCOMPARE(table.color(color, tone), palette.getQColor(color, tone));
+        }
+        // 超出范围的色调限定到边界
+        QCOMPARE(table.color(color, 105), palette.getQColor(color, 105));
+        QCOMPARE(table.color(color, -5), palette.getQColor(color, -5));
+    }
+}
+
+void TestQWPalette::paletteCacheSharesEntries() {
+    QWPaletteCache& cache = QWPaletteCache::instance();
+    cache.clear();
+    const auto a = cache.acquire(QColor(19, 149, 192), 80, 20);
+    const auto b = cache.acquire(QColor(19, 149, 192), 80, 20);
+    QCOMPARE(a.palette.data(), b.palette.data());
+    QCOMPARE(a.tones.data(), b.tones.data());
+
+    // 不同色调共享调色板，但占用独立的缓存键
+    const auto c = cache.acquire(QColor(19, 149, 192), 90, 10);
+    QCOMPARE(a.palette.data(), c.palette.data());
+    QCOMPARE(cache.size(), 2);
+
+    // 不同的色域映射是不同的变体
+    const auto d = cache.acquire(QColor(19, 149, 192), 80, 20, GamutMapping::ReduceChroma);
+    QVERIFY(a.palette.data() != d.palette.data());
+    QVERIFY(d.palette->gamutMapping() == GamutMapping::ReduceChroma);
+}
+
+void TestQWPalette::paletteCacheEvictsLeastRecentlyUsed() {
+    QWPaletteCache& cache = QWPaletteCache::instance();
+    cache.clear();
+    const int oldCapacity = cache.capacity();
+    cache.setCapacity(2);
+
+    const auto red = cache.acquire(QColor(200, 30, 30), 80, 20);
+    cache.acquire(QColor(30, 200, 30), 80, 20);
+    cache.acquire(QColor(200, 30, 30), 80, 20); // red 变为最近使用
+    cache.acquire(QColor(30, 30, 200), 80, 20); // 淘汰 green
+    QCOMPARE(cache.size(), 2);
+    QCOMPARE(cache.acquire(QColor(200, 30, 30), 80, 20).palette.data(), red.palette.data());
+
+    // 被淘汰的对象仍由持有者保持有效
+    cache.clear();
+    QCOMPARE(red.tones->color(QWPalette::mainColor, 40), red.palette->getQColor(QWPalette::mainColor, 40));
+
+    cache.setCapacity(oldCapacity);
+}
+
+void TestQWPalette::extractSeedColorFindsDominantHue() {
+    QImage image(300, 200, QImage::Format_ARGB32);
+    image.fill(QColor(40, 90, 200));
+    for (int y = 0; y < 40; ++y) {
+        for (int x = 0; x < 300; ++x) {
+            image.setPixel(x, y, qRgb(230, 120, 20));
+        }
+    }
+
+    std::vector<HCTColor> colors;
+    extractSeedColor(image, colors);
+    QVERIFY(!colors.empty());
+    const HCTColor expected = RGB2HCT(RGBColor(40, 90, 200));
+    QVERIFY(hueDistance(colors.front().hue, expected.hue) < 10.0);
+}
+
+void TestQWPalette::extractSeedColorFallsBackToGray() {
+    // 没有任何桶通过彩度过滤时，按像素数量返回灰阶颜色
+    QImage image(64, 64, QImage::Format_ARGB32);
+    image.fill(QColor(128, 128, 128));
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            image.setPixel(x, y, qRgb(20, 20, 20));
+        }
+    }
+
+    std::vector<HCTColor> colors;
+    extractSeedColor(image, colors);
+    QCOMPARE(colors.size(), size_t(2));
+    const HCTColor expected = RGB2HCT(RGBColor(136, 136, 136), ColorPrecision::Float); // 桶中心，Float 精度
+    QCOMPARE(colors.front().tone, expected.tone);
+    QVERIFY(colors.front().chroma < 5.0);
+}
+
+void TestQWPalette::parallelExtractionMatchesSerial() {
+    // 全分辨率、足够大的图像才会真正拆分到线程池
+    QImage image(1600, 1200, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            line[x] = qRgba((x * 7) & 0xFF, (y * 3) & 0xFF, (x ^ y) & 0xFF, (x + y) & 0xFF);
+        }
+    }
+
+    SeedExtractionOptions options;
+    options.maxDimension = 0;
+    std::vector<HCTColor> serial;
+    extractSeedColor(image, serial, options);
+
+    options.parallel = true;
+    std::vector<HCTColor> parallel;
+    extractSeedColor(image, parallel, options);
+
+    QCOMPARE(parallel.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        QCOMPARE(parallel[i].hue, serial[i].hue);
+        QCOMPARE(parallel[i].chroma, serial[i].chroma);
+        QCOMPARE(parallel[i].tone, serial[i].tone);
+    }
+}
+
+void TestQWPalette::quantizerHonorsAlphaAndRowTails() {
+    // 宽度不是 SIMD 批量大小的倍数，行尾像素走标量路径；
+    // alpha = 127 的像素必须被忽略，alpha = 128 的像素必须被计入
+    for (int width : {1, 7, 15, 17, 33}) {
+        QImage image(width, 64, QImage::Format_ARGB32);
+        image.fill(qRgba(40, 90, 200, 127));
+        for (int y = 0; y < 8; ++y) {
+            image.setPixel(width - 1, y, qRgba(230, 120, 20, 128));
+        }
+
+        SeedExtractionOptions options;
+        options.maxDimension = 0;
+        std::vector<HCTColor> colors;
+        extractSeedColor(image, colors, options);
+        QCOMPARE(colors.size(), size_t(1));
+        const HCTColor expected = RGB2HCT(RGBColor(232, 120, 24), ColorPrecision::Float); // 桶中心，Float 精度
+        QCOMPARE(colors.front().hue, expected.hue);
+    }
+}
+
+void TestQWPalette::inPlaceSamplingMatchesLegacy_data() {
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("sampling");
+
+    const QList<QPair<QImage::Format, const char*>> formats = {
+        {QImage::Format_RGB32, "RGB32"},
+        {QImage::Format_ARGB32_Premultiplied, "ARGB32_Premultiplied"},
+        {QImage::Format_RGBA8888, "RGBA8888"},
+        {QImage::Format_RGB888, "RGB888"},
+        {QImage::Format_Grayscale8, "Grayscale8"}, // 不支持原地读取，转换一次后采样
+    };
+    for (const auto& format : formats) {
+        QTest::addRow("%s strided", format.second) << static_cast<int>(format.first)
+                                                   << static_cast<int>(SeedSampling::Strided);
+        QTest::addRow("%s box", format.second) << static_cast<int>(format.first)
+                                               << static_cast<int>(SeedSampling::Box);
+    }
+}
+
+void TestQWPalette::inPlaceSamplingMatchesLegacy() {
+    QFETCH(int, format);
+    QFETCH(int, sampling);
+
+    // 由 4x4 纯色块组成的图像：中心采样与盒式平均都应恰好还原每个色块
+    QImage blocks(128, 96, QImage::Format_ARGB32);
+    QImage source(512, 384, QImage::Format_ARGB32);
+    for (int y = 0; y < source.height(); ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(source.scanLine(y));
+        for (int x = 0; x < source.width(); ++x) {
+            const int bx = x / 4;
+            const int by = y / 4;
+            line[x] = qRgb((bx * 37) & 0xFF, (by * 53) & 0xFF, ((bx + by) * 11) & 0xFF);
+            blocks.setPixel(bx, by, line[x]);
+        }
+    }
+
+    SeedExtractionOptions legacy;
+    legacy.maxDimension = 0;
+    std::vector<HCTColor> expected;
+    extractSeedColor(blocks.convertToFormat(QImage::Format(format)), expected, legacy);
+
+    SeedExtractionOptions options;
+    options.maxDimension = 128;
+    options.sampling = static_cast<SeedSampling>(sampling);
+    std::vector<HCTColor> colors;
+    extractSeedColor(source.convertToFormat(QImage::Format(format)), colors, options);
+
+    QCOMPARE(colors.size(), expected.size());
+    for (size_t i = 0; i < colors.size(); ++i) {
+        QCOMPARE(colors[i].hue, expected[i].hue);
+        QCOMPARE(colors[i].tone, expected[i].tone);
+    }
+}
+
+void TestQWPalette::extractSeedColorFromFileAndDevice() {
+    QImage image(1200, 900, QImage::Format_RGB32);
+    image.fill(QColor(40, 90, 200));
+    for (int y = 0; y < 200; ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, qRgb(230, 120, 20));
+        }
+    }
+    const HCTColor expected = RGB2HCT(RGBColor(40, 90, 200));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("seed.png");
+    QVERIFY(image.save(path));
+
+    std::vector<HCTColor> fromFile;
+    QVERIFY(extractSeedColorFromFile(path, fromFile));
+    QVERIFY(!fromFile.empty());
+    QVERIFY(hueDistance(fromFile.front().hue, expected.hue) < 10.0);
+
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(image.save(&buffer, "PNG"));
+    buffer.close();
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    std::vector<HCTColor> fromDevice;
+    QVERIFY(extractSeedColor(&buffer, fromDevice));
+    QCOMPARE(fromDevice.size(), fromFile.size());
+    QCOMPARE(fromDevice.front().hue, fromFile.front().hue);
+
+    // 无法解码时返回 false 并清空结果
+    QByteArray garbage("not an image");
+    QBuffer broken(&garbage);
+    QVERIFY(broken.open(QIODevice::ReadOnly));
+    QVERIFY(!extractSeedColor(&broken, fromDevice));
+    QVERIFY(fromDevice.empty());
+    QVERIFY(!extractSeedColorFromFile(dir.filePath("missing.png"), fromFile));
+}
+
+void TestQWPalette::asyncExtractionCoalescesRequests() {
+    QImage image(2000, 1500, QImage::Format_ARGB32);
+    image.fill(QColor(40, 90, 200));
+    SeedExtractionOptions options;
+    options.maxDimension = 0;
+    std::vector<HCTColor> expected;
+    extractSeedColor(image, expected, options);
+
+    const QString channel = QStringLiteral("tst_qwpalette");
+    QFuture<std::vector<HCTColor>> older = extractSeedColorAsync(image, options, channel);
+    QFuture<std::vector<HCTColor>> newer = extractSeedColorAsync(image, options, channel);
+    QFuture<std::vector<HCTColor>> other = extractSeedColorAsync(image, options, channel + "-other");
+
+    newer.waitForFinished();
+    other.waitForFinished();
+    older.waitForFinished();
+    QCOMPARE(newer.resultCount(), 1);
+    QCOMPARE(other.resultCount(), 1);
+    QCOMPARE(newer.result().size(), expected.size());
+    QCOMPARE(newer.result().front().hue, expected.front().hue);
+    // 旧请求可能在被取代前已经完成，此时结果必须仍然正确
+    if (older.resultCount() > 0) {
+        QCOMPARE(older.result().front().hue, expected.front().hue);
+    }
+
+    // 调用方取消后任务必须结束，不能悬挂
+    QFuture<std::vector<HCTColor>> canceled = extractSeedColorAsync(image, options, channel);
+    canceled.cancel();
+    canceled.waitForFinished();
+    QVERIFY(canceled.isCanceled());
+}
+
+void TestQWPalette::seedCachePersistsResults() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QWSeedCache& cache = QWSeedCache::instance();
+    const QString oldPath = cache.filePath();
+    const QString cachePath = dir.filePath("seedcache.bin");
+    cache.setFilePath(cachePath);
+    cache.clear();
+
+    QImage image(400, 300, QImage::Format_RGB32);
+    image.fill(QColor(40, 90, 200));
+    const QString imagePath = dir.filePath("cover.png");
+    QVERIFY(image.save(imagePath));
+
+    std::vector<HCTColor> extracted;
+    QVERIFY(cache.extractFromFile(imagePath, extracted));
+    QVERIFY(!extracted.empty());
+    QCOMPARE(cache.size(), 1);
+
+    // 重新打开：内存缓存被丢弃，结果从磁盘读取
+    cache.setFilePath(cachePath);
+    std::vector<HCTColor> cached;
+    QVERIFY(cache.lookup(QWSeedCache::fileKey(imagePath), cached));
+    QCOMPARE(cached.size(), extracted.size());
+    QCOMPARE(cached.front().hue, extracted.front().hue);
+    QCOMPARE(cached.front().tone, extracted.front().tone);
+
+    // 参数不同是不同的条目
+    SeedExtractionOptions strided;
+    strided.sampling = SeedSampling::Strided;
+    QVERIFY(!cache.lookup(QWSeedCache::fileKey(imagePath, strided), cached));
+
+    // 文件尾部的不完整记录被丢弃，之前的记录仍然有效
+    {
+        QFile file(cachePath);
+        QVERIFY(file.open(QIODevice::Append));
+        file.write("\x01\x02\x03", 3);
+    }
+    cache.setFilePath(cachePath);
+    QVERIFY(cache.lookup(QWSeedCache::fileKey(imagePath), cached));
+    QCOMPARE(cache.size(), 1);
+
+    // 按内容哈希：相同数据命中，与路径无关
+    QFile encoded(imagePath);
+    QVERIFY(encoded.open(QIODevice::ReadOnly));
+    const QByteArray data = encoded.readAll();
+    QVERIFY(encoded.seek(0));
+    QVERIFY(cache.extractFromDevice(&encoded, cached));
+    QCOMPARE(cache.size(), 2);
+    std::vector<HCTColor> byContent;
+    QVERIFY(cache.lookup(QWSeedCache::contentKey(data), byContent));
+    QCOMPARE(byContent.front().hue, extracted.front().hue);
+
+    cache.clear();
+    QCOMPARE(cache.size(), 0);
+    QVERIFY(!QFile::exists(cachePath));
+    cache.setFilePath(oldPath);
+}
+
+void TestQWPalette::batchExtractorMatchesSingleFile() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QStringList paths;
+    for (int i = 0; i < 12; ++i) {
+        QImage image(320, 240, QImage::Format_RGB32);
+        image.fill(QColor::fromHsv((i * 30) % 360, 200, 220));
+        const QString path = dir.filePath(QString("thumb%1.png").arg(i));
+        QVERIFY(image.save(path));
+        paths.append(path);
+    }
+    const QString brokenPath = dir.filePath("broken.png");
+    {
+        QFile broken(brokenPath);
+        QVERIFY(broken.open(QIODevice::WriteOnly));
+        broken.write("not an image");
+    }
+    paths.insert(5, brokenPath);
+    paths.append(dir.filePath("missing.png"));
+
+    QWSeedExtractor extractor;
+    extractor.setUseCache(false);
+    extractor.setMaxWorkers(3);
+    extractor.setQueueDepth(2);
+
+    std::vector<QWSeedExtractor::Result> results(paths.size());
+    int lastFinished = 0;
+    int callbacks = 0;
+    bool progressInOrder = true;
+    // 回调可能在工作线程中执行，只记录，回到测试线程后再检查
+    const int succeeded = extractor.extractAll(paths, [&](const QWSeedExtractor::Result& result) {
+        ++callbacks;
+        results[result.index] = result;
+    }, [&](int finished, int total) {
+        progressInOrder = progressInOrder && total == paths.size() && finished == lastFinished + 1;
+        lastFinished = finished;
+    });
+    QVERIFY(progressInOrder);
+    QCOMPARE(succeeded, int(paths.size()) - 2);
+    QCOMPARE(callbacks, int(paths.size()));
+    QCOMPARE(lastFinished, int(paths.size()));
+
+    for (int i = 0; i < paths.size(); ++i) {
+        const QWSeedExtractor::Result& result = results[i];
+        QCOMPARE(result.index, i);
+        QCOMPARE(result.path, paths.at(i));
+        QVERIFY(!result.cached);
+        std::vector<HCTColor> expected;
+        QCOMPARE(result.ok, extractSeedColorFromFile(paths.at(i), expected));
+        QCOMPARE(result.colors.size(), expected.size());
+        if (result.ok) {
+            QCOMPARE(result.colors.front().hue, expected.front().hue);
+            QCOMPARE(result.colors.front().tone, expected.front().tone);
+        }
+    }
+
+    // 运行中的取消只结束这一次运行；已经开始解码的图片最多各回调一次
+    callbacks = 0;
+    extractor.extractAll(paths, [&](const QWSeedExtractor::Result&) {
+        ++callbacks;
+        extractor.cancel();
+    });
+    QVERIFY(callbacks >= 1);
+    QVERIFY(callbacks < int(paths.size()));
+
+    // 运行结束后才到达的取消不影响之后的运行
+    extractor.cancel();
+    callbacks = 0;
+    QCOMPARE(extractor.extractAll(paths, [&](const QWSeedExtractor::Result&) { ++callbacks; }), succeeded);
+    QCOMPARE(callbacks, int(paths.size()));
+}
+
+void TestQWPalette::seedTrackerFollowsFrames() {
+    QImage first(640, 360, QImage::Format_RGB32);
+    first.fill(QColor(40, 90, 200));
+    for (int y = 0; y < 90; ++y) {
+        for (int x = 0; x < first.width(); ++x) {
+            first.setPixel(x, y, qRgb(230, 120, 20));
+        }
+    }
+    std::vector<HCTColor> expected;
+    extractSeedColor(first, expected);
+
+    QWSeedTracker tracker;
+    QVERIFY(tracker.update(first));
+    QCOMPARE(tracker.colors().size(), expected.size());
+    QCOMPARE(tracker.colors().front().hue, expected.front().hue);
+
+    // 静止画面：不再评分
+    const int scorings = tracker.scoringCount();
+    for (int i = 0; i < 20; ++i) {
+        QVERIFY(!tracker.update(first));
+    }
+    QCOMPARE(tracker.scoringCount(), scorings);
+
+    // 切换画面：经过平滑逐渐跟上，且只在可能改变结果时评分
+    QImage second(640, 360, QImage::Format_RGB32);
+    second.fill(QColor(30, 160, 60));
+    extractSeedColor(second, expected);
+    bool changed = false;
+    for (int i = 0; i < 60; ++i) {
+        changed = tracker.update(second) || changed;
+    }
+    QVERIFY(changed);
+    QCOMPARE(tracker.colors().front().hue, expected.front().hue);
+    QVERIFY(tracker.scoringCount() - scorings < 60);
+    QCOMPARE(tracker.frameCount(), 81);
+
+    // 局部更新：不平滑时立即反映变化区域
+    tracker.reset();
+    tracker.setSmoothing(1.0);
+    tracker.update(second);
+    QImage partial = second;
+    for (int y = 0; y < partial.height(); ++y) {
+        for (int x = 0; x < 480; ++x) {
+            partial.setPixel(x, y, qRgb(200, 30, 40));
+        }
+    }
+    extractSeedColor(partial, expected);
+    QVERIFY(tracker.update(partial, QRect(0, 0, 480, 360)));
+    QCOMPARE(tracker.colors().front().hue, expected.front().hue);
+}
+
+void TestQWPalette::quantizerDepthsAreDeterministic_data() {
+    QTest::addColumn<int>("bits");
+    QTest::addColumn<int>("quantizer");
+    for (int bits = 4; bits <= 6; ++bits) {
+        QTest::addRow("%d-bit histogram", bits) << bits << int(SeedQuantizer::Histogram);
+        QTest::addRow("%d-bit kmeans", bits) << bits << int(SeedQuantizer::KMeans);
+    }
+}
+
+void TestQWPalette::quantizerDepthsAreDeterministic() {
+    QFETCH(int, bits);
+    QFETCH(int, quantizer);
+    const QImage image = noisyPhoto(1600, 1200);
+
+    SeedExtractionOptions options;
+    options.maxDimension = 0;
+    options.binBits = bits;
+    options.quantizer = SeedQuantizer(quantizer);
+    std::vector<HCTColor> serial;
+    extractSeedColor(image, serial, options);
+    QVERIFY(!serial.empty());
+
+    // 稀疏直方图的哈希布局与合并顺序不影响结果
+    options.parallel = true;
+    std::vector<HCTColor> parallel;
+    extractSeedColor(image, parallel, options);
+    QCOMPARE(parallel.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        QCOMPARE(parallel[i].hue, serial[i].hue);
+        QCOMPARE(parallel[i].chroma, serial[i].chroma);
+        QCOMPARE(parallel[i].tone, serial[i].tone);
+    }
+}
+
+void TestQWPalette::clusteringRefinesNoisySeeds() {
+    const QImage image = noisyPhoto(1920, 1080);
+    const HCTColor truth[] = {RGB2HCT(RGBColor(100, 150, 200)), RGB2HCT(RGBColor(220, 120, 40))};
+    // 两种真实颜色各自与最接近的种子之间的 ΔE，取较大者
+    const auto seedError = [&truth](const std::vector<HCTColor>& seeds) {
+        double worst = 0.0;
+        for (const HCTColor& color : truth) {
+            double best = std::numeric_limits<double>::max();
+            for (const HCTColor& seed : seeds) best = std::min(best, deltaE(color, seed));
+            worst = std::max(worst, best);
+        }
+        return worst;
+    };
+
+    SeedExtractionOptions options;
+    options.sampling = SeedSampling::Strided;
+    std::vector<HCTColor> coarse;
+    extractSeedColor(image, coarse, options);
+
+    options.binBits = 6;
+    options.quantizer = SeedQuantizer::KMeans;
+    std::vector<HCTColor> clustered;
+    extractSeedColor(image, clustered, options);
+
+    qInfo("seed dE: 4-bit histogram %.2f, 6-bit kmeans %.2f", seedError(coarse), seedError(clustered));
+    QVERIFY(seedError(clustered) < seedError(coarse));
+    QVERIFY(seedError(clustered) < 1.0);
+
+    // 灰阶兜底同样适用于聚类结果
+    QImage gray(200, 200, QImage::Format_RGB32);
+    gray.fill(QColor(128, 128, 128));
+    extractSeedColor(gray, clustered, options);
+    QCOMPARE(clustered.size(), size_t(1));
+    QVERIFY(clustered.front().chroma < 5.0);
+}
+
+void TestQWPalette::iconTintMatchesReference() {
+    // 宽度覆盖 SIMD 批量的整数倍与行尾；每个通道必须等于 round(color × alpha / 255)
+    const QColor color(200, 60, 120, 180);
+    const QRgb premultiplied = qPremultiply(color.rgba());
+    const auto expected = [premultiplied](int alpha) {
+        const auto scale = [alpha](int channel) { return (channel * alpha + 127) / 255; };
+        return qRgba(scale(qRed(premultiplied)), scale(qGreen(premultiplied)),
+                     scale(qBlue(premultiplied)), scale(qAlpha(premultiplied)));
+    };
+
+    for (QImage::Format format : {QImage::Format_Alpha8, QImage::Format_ARGB32,
+                                  QImage::Format_ARGB32_Premultiplied, QImage::Format_RGBA8888}) {
+        for (int width : {1, 3, 8, 17, 37}) {
+            QImage mask(width, 3, QImage::Format_ARGB32);
+            for (int y = 0; y < mask.height(); ++y) {
+                for (int x = 0; x < width; ++x) {
+                    mask.setPixel(x, y, qRgba(0, 0, 0, (x * 37 + y * 101) & 0xFF));
+                }
+            }
+            mask = mask.convertToFormat(format);
+            mask.setDevicePixelRatio(2.0);
+
+            const QImage tinted = QWIconTinter::tinted(mask, color);
+            QCOMPARE(tinted.format(), QImage::Format_ARGB32_Premultiplied);
+            QCOMPARE(tinted.size(), mask.size());
+            QCOMPARE(tinted.devicePixelRatio(), 2.0);
+            for (int y = 0; y < mask.height(); ++y) {
+                const QRgb* line = reinterpret_cast<const QRgb*>(tinted.constScanLine(y));
+                for (int x = 0; x < width; ++x) {
+                    QCOMPARE(line[x], expected((x * 37 + y * 101) & 0xFF));
+                }
+            }
+        }
+    }
+    QVERIFY(QWIconTinter::tinted(QImage(), color).isNull());
+}
+
+void TestQWPalette::themeManagerSharesPalettes() {
+    QWThemeManager manager;
+    const QColor seed(19, 149, 192);
+    const QPalette light = manager.palette(seed, 80, 20, false);
+
+    // 同一配置的请求共享同一份数据，颜色来自色调表
+    QVERIFY(manager.palette(seed, 80, 20, false).isCopyOf(light));
+    const auto tones = QWPaletteCache::instance().acquire(seed, 80, 20).tones;
+    QCOMPARE(light.color(QPalette::Window).rgb(), tones->rgb(QWPalette::neutralAccent, 80));
+    QCOMPARE(light.color(QPalette::WindowText).rgb(), tones->rgb(QWPalette::neutralAccent, 20));
+    QCOMPARE(light.color(QPalette::AlternateBase).rgb(), tones->rgb(QWPalette::neutralColor, 75));
+
+    // 深色模式与浅色模式一起构建，切换时直接换入，与直接构建的结果一致
+    QVERIFY(manager.contains(seed, 80, 20, true));
+    const QPalette dark = manager.palette(seed, 80, 20, true);
+    QVERIFY(manager.palette(seed, 80, 20, true).isCopyOf(dark));
+    const QPalette expected = QWThemeManager::createPalette(*tones, 80, 20, true);
+    for (QPalette::ColorRole role : {QPalette::Window, QPalette::Text, QPalette::Highlight, QPalette::LinkVisited}) {
+        QCOMPARE(dark.color(role), expected.color(role));
+    }
+
+    // 预热在后台计算色调表，回到 GUI 线程后两个模式都已就绪
+    const QColor next(201, 82, 40);
+    QVERIFY(!manager.contains(next, 80, 20, false));
+    manager.prewarm(next, 80, 20);
+    QTRY_VERIFY(manager.contains(next, 80, 20, false));
+    QVERIFY(manager.contains(next, 80, 20, true));
+    const auto nextTones = QWPaletteCache::instance().acquire(next, 80, 20).tones;
+    const QPalette warmed = manager.palette(next, 80, 20, true);
+    const QPalette direct = QWThemeManager::createPalette(*nextTones, 80, 20, true);
+    for (QPalette::ColorRole role : {QPalette::Window, QPalette::Text, QPalette::Highlight, QPalette::LinkVisited}) {
+        QCOMPARE(warmed.color(role), direct.color(role));
+    }
+
+    QVERIFY(!manager.contains(seed, 70, 20, false));
+    manager.clear();
+    QVERIFY(!manager.contains(seed, 80, 20, false));
+}
+
+void TestQWPalette::changedRolesReportsDifferences() {
+    const auto tones = QWPaletteCache::instance().acquire(QColor(19, 149, 192), 80, 20).tones;
+    const QPalette light = QWThemeManager::createPalette(*tones, 80, 20, false);
+    QCOMPARE(QWThemeManager::changedRoles(light, QWThemeManager::createPalette(*tones, 80, 20, false)), 0u);
+
+    // 只有一个颜色组不同也算变化
+    QPalette edited = light;
+    edited.setColor(QPalette::Disabled, QPalette::Highlight, Qt::red);
+    edited.setColor(QPalette::Window, Qt::blue);
+    QCOMPARE(QWThemeManager::changedRoles(light, edited), (1u << QPalette::Highlight) | (1u << QPalette::Window));
+
+    // 浅色与深色之间所有主题角色都会变化
+    const quint32 toggled = QWThemeManager::changedRoles(light, QWThemeManager::createPalette(*tones, 80, 20, true));
+    for (QPalette::ColorRole role : {QPalette::Window, QPalette::WindowText, QPalette::Base, QPalette::Button, QPalette::Highlight}) {
+        QVERIFY(toggled & (1u << role));
+    }
+    QVERIFY(!(toggled & (1u << QPalette::ToolTipBase)));
+}
+
+void TestQWPalette::themeTransitionInterpolatesInHct() {
+    const auto tones = QWPaletteCache::instance().acquire(QColor(19, 149, 192), 80, 20).tones;
+    const QPalette light = QWThemeManager::createPalette(*tones, 80, 20, false);
+    const QPalette dark = QWThemeManager::createPalette(*tones, 80, 20, true);
+
+    constexpr int kSteps = 8;
+    const std::vector<QPalette> frames = QWThemeManager::interpolate(light, dark, kSteps);
+    QCOMPARE(int(frames.size()), kSteps);
+    QVERIFY(frames.back().isCopyOf(dark));
+
+    // 背景的色调单调地从浅色走到深色，色相保持在种子附近而不是穿过灰色
+    const HCTColor start = RGB2HCT(RGBColor(light.color(QPalette::Window)));
+    double previousTone = start.tone;
+    for (const QPalette& frame : frames) {
+        const HCTColor hct = RGB2HCT(RGBColor(frame.color(QPalette::Window)));
+        QVERIFY(hct.tone < previousTone);
+        if (hct.chroma > 2.0) {
+            QVERIFY(hueDistance(hct.hue, start.hue) < 10.0);
+        }
+        previousTone = hct.tone;
+        QCOMPARE(frame.color(QPalette::ToolTipBase), dark.color(QPalette::ToolTipBase));
+    }
+
+    QCOMPARE(QWThemeManager::interpolate(light, light, kSteps).size(), size_t(kSteps));
+}
+
+void TestQWPalette::styleSheetTemplateRendersAndCaches() {
+    const QColor seed(19, 149, 192);
+    const auto tones = QWPaletteCache::instance().acquire(seed, 80, 20).tones;
+    const QWStyleSheet sheet(QStringLiteral(
+        "QPushButton { color: @mainColor.40; background: @neutralColor; }\n"
+        "QLabel[mail=\"a@@b\"] { border: 1px solid @accentColor.95; } @font @"));
+    QCOMPARE(sheet.placeholderCount(), 3);
+
+    // 省略色调时使用当前模式的色调；未知名称与单独的 @ 按原文保留
+    const QString expected = QStringLiteral(
+        "QPushButton { color: %1; background: %2; }\n"
+        "QLabel[mail=\"a@b\"] { border: 1px solid %3; } @font @")
+        .arg(tones->color(QWPalette::mainColor, 40).name(),
+             tones->color(QWPalette::neutralColor, 20).name(),
+             tones->color(QWPalette::accentColor, 95).name());
+    QCOMPARE(sheet.render(*tones, 20), expected);
+    QCOMPARE(sheet.render(seed, 80, 20, true), expected);
+
+    // 命中缓存时返回同一份数据；副本共享缓存
+    QVERIFY(sheet.isCached(seed, 80, 20, true));
+    const QWStyleSheet copy = sheet;
+    QVERIFY(copy.render(seed, 80, 20, true).isSharedWith(sheet.render(seed, 80, 20, true)));
+
+    // 另一个模式在后台渲染
+    QVERIFY(!sheet.isCached(seed, 80, 20, false));
+    sheet.prerender(seed, 80, 20, false);
+    QTRY_VERIFY(sheet.isCached(seed, 80, 20, false));
+    QCOMPARE(sheet.render(seed, 80, 20, false), sheet.render(*tones, 80));
+
+    QVERIFY(QWStyleSheet().isNull());
+    QVERIFY(QWStyleSheet().render(seed, 80, 20, false).isEmpty());
+}
+
+void TestQWPalette::toneForContrastMatchesExhaustiveSearch() {
+    const auto contrast = [](double a, double b) {
+        return (std::max(a, b) + 0.05) / (std::min(a, b) + 0.05);
+    };
+    for (const QColor& seed : {QColor(19, 149, 192), QColor(200, 30, 90), QColor(128, 128, 128), QColor(250, 220, 40)}) {
+        QWPalette palette(RGBColor(seed.red(), seed.green(), seed.blue()));
+        for (int role = 0; role < 5; ++role) {
+            const auto n = static_cast<QWPalette::QWColor>(role);
+            for (int tone = 0; tone <= 100; ++tone) {
+                // 亮度表与逐个转换的结果一致，且随色调单调
+                const double expected = wcagLuminance(palette.getQColor(n, tone));
+                QVERIFY(std::fabs(palette.relativeLuminance(n, tone) - expected) < 1e-9);
+                if (tone > 0) {
+                    QVERIFY(palette.relativeLuminance(n, tone) >= palette.relativeLuminance(n, tone - 1));
+                }
+            }
+
+            // 结果是背景同侧满足对比度、最接近背景的色调
+            for (int background = 0; background <= 100; background += 5) {
+                const double backgroundLuminance = palette.relativeLuminance(QWPalette::neutralColor, background);
+                for (double ratio : {3.0, 4.5, 7.0}) {
+                    int best = -1;
+                    for (int tone = 0; tone <= 100; ++tone) {
+                        const bool side = background >= 50 ? tone < background : tone > background;
+                        if (side && contrast(palette.relativeLuminance(n, tone), backgroundLuminance) >= ratio
+                            && (best < 0 || std::abs(tone - background) < std::abs(best - background))) {
+                            best = tone;
+                        }
+                    }
+                    const int tone = palette.toneForContrast(n, background, ratio, QWPalette::neutralColor);
+                    if (best >= 0) {
+                        QCOMPARE(tone, best);
+                    } else if (tone != 0 && tone != 100) {
+                        QVERIFY(contrast(palette.relativeLuminance(n, tone), backgroundLuminance) >= ratio);
+                    }
+                }
+            }
+        }
+    }
+
+    // 拷贝共享已构建的表；修改种子后重新构建
+    QWPalette palette(RGBColor(19, 149, 192));
+    const double before = palette.relativeLuminance(QWPalette::mainColor, 40);
+    const QWPalette copy = palette;
+    palette.setSeedColor(RGBColor(200, 30, 90));
+    QCOMPARE(copy.relativeLuminance(QWPalette::mainColor, 40), before);
+    QVERIFY(palette.relativeLuminance(QWPalette::mainColor, 40) != before);
+}
+
+void TestQWPalette::themeManagerEnforcesTextContrast() {
+    const QColor seed(19, 149, 192);
+    const auto colors = QWPaletteCache::instance().acquire(seed, 65, 40);
+    const auto contrast = [](const QColor& a, const QColor& b) {
+        const double x = wcagLuminance(a), y = wcagLuminance(b);
+        return (std::max(x, y) + 0.05) / (std::min(x, y) + 0.05);
+    };
+
+    // 色调 65 / 40 太接近，直接交换达不到 4.5:1
+    for (bool dark : {false, true}) {
+        const QPalette plain = QWThemeManager::createPalette(*colors.tones, 65, 40, dark);
+        QVERIFY(contrast(plain.color(QPalette::WindowText), plain.color(QPalette::Window)) < 4.5);
+
+        const QPalette readable = QWThemeManager::createPalette(colors, 65, 40, dark, 4.5);
+        QVERIFY(contrast(readable.color(QPalette::WindowText), readable.color(QPalette::Window)) >= 4.5);
+        QVERIFY(contrast(readable.color(QPalette::Text), readable.color(QPalette::Base)) >= 4.5);
+        QVERIFY(contrast(readable.color(QPalette::Text), readable.color(QPalette::AlternateBase)) >= 4.5);
+        QVERIFY(contrast(readable.color(QPalette::ButtonText), readable.color(QPalette::Button)) >= 4.5);
+        QVERIFY(contrast(readable.color(QPalette::HighlightedText), readable.color(QPalette::Highlight)) >= 4.5);
+        QCOMPARE(readable.color(QPalette::Window), plain.color(QPalette::Window));
+
+        // 0 表示不检查，与原来的结果相同
+        QCOMPARE(QWThemeManager::createPalette(colors, 65, 40, dark, 0.0).color(QPalette::WindowText),
+                 plain.color(QPalette::WindowText));
+    }
+
+    // 已经足够的默认色调保持不变
+    const auto standard = QWPaletteCache::instance().acquire(seed, 90, 10);
+    QCOMPARE(QWThemeManager::createPalette(standard, 90, 10, false, 4.5).color(QPalette::WindowText),
+             QWThemeManager::createPalette(*standard.tones, 90, 10, false).color(QPalette::WindowText));
+
+    // 对比度参与缓存键
+    QWThemeManager manager;
+    const QPalette readable = manager.palette(seed, 65, 40, false, 4.5);
+    QVERIFY(manager.contains(seed, 65, 40, false, 4.5));
+    QVERIFY(!manager.contains(seed, 65, 40, false));
+    QVERIFY(manager.palette(seed, 65, 40, false).color(QPalette::WindowText) != readable.color(QPalette::WindowText));
+}
+
+void TestQWPalette::themeSnapshotRoundTrips() {
+    const QColor seed(201, 64, 120);
+    QWThemeManager manager;
+    const QWThemeSnapshot snapshot = QWThemeSnapshot::capture(seed, 75, 25, 4.5, &manager);
+    QVERIFY(snapshot.isValid());
+    QVERIFY(snapshot.matches(seed, 75, 25, 4.5));
+    QVERIFY(!snapshot.matches(seed, 75, 25));
+    QVERIFY(!snapshot.matches(QColor(201, 64, 121), 75, 25, 4.5));
+    QVERIFY(!QWThemeSnapshot().isValid());
+    QVERIFY(QWThemeSnapshot().toByteArray().isEmpty());
+
+    // 字节往返：色调表与两个 QPalette 完全一致
+    const QByteArray data = snapshot.toByteArray();
+    const QWThemeSnapshot loaded = QWThemeSnapshot::fromByteArray(data);
+    QVERIFY(loaded.isValid());
+    QVERIFY(loaded.matches(seed, 75, 25, 4.5));
+    const QWPaletteCache::Entry expected = QWPaletteCache::instance().acquire(seed, 75, 25);
+    QVERIFY(std::equal(expected.tones->data(), expected.tones->data() + QWToneTable::kRoleCount * QWToneTable::kToneCount,
+                       loaded.colors().tones->data()));
+    QCOMPARE(loaded.colors().palette->getQColor(QWPalette::accentColor, 40),
+             expected.palette->getQColor(QWPalette::accentColor, 40));
+    for (bool dark : {false, true}) {
+        QCOMPARE(loaded.palette(dark), manager.palette(seed, 75, 25, dark, 4.5));
+    }
+
+    // 损坏或截断的数据得到无效快照
+    QByteArray corrupted = data;
+    corrupted[corrupted.size() / 2] = char(corrupted[corrupted.size() / 2] ^ 0x5a);
+    QVERIFY(!QWThemeSnapshot::fromByteArray(corrupted).isValid());
+    QVERIFY(!QWThemeSnapshot::fromByteArray(data.left(data.size() - 3)).isValid());
+    QVERIFY(!QWThemeSnapshot::fromByteArray(QByteArray("QWTS")).isValid());
+
+    // 恢复后两级缓存直接命中快照中的对象
+    QWPaletteCache::instance().clear();
+    QWThemeManager restoredManager;
+    loaded.restore(&restoredManager);
+    QCOMPARE(QWPaletteCache::instance().acquire(seed, 75, 25).tones, loaded.colors().tones);
+    QVERIFY(restoredManager.contains(seed, 75, 25, false, 4.5));
+    QVERIFY(restoredManager.contains(seed, 75, 25, true, 4.5));
+    QCOMPARE(restoredManager.palette(seed, 75, 25, true, 4.5), loaded.palette(true));
+
+    // 文件往返
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("theme.bin");
+    QVERIFY(snapshot.saveToFile(path));
+    QVERIFY(QWThemeSnapshot::loadFromFile(path).matches(seed, 75, 25, 4.5));
+    QVERIFY(!QWThemeSnapshot::loadFromFile(dir.filePath("missing.bin")).isValid());
+}
+
+QTEST_GUILESS_MAIN(TestQWPalette)
+#include "tst_qwpalette.moc"
@@ -0,0 +1,107 @@
+// QtWin/tests/tst_qwwindow.cpp
+//
+// QWWindow 单元测试。QWWindow 依赖 QWApplication，因此不使用 QTEST_MAIN，
+// 而是在 main() 中创建 QWApplication；未设置 QT_QPA_PLATFORM 时使用 offscreen。
+
+#include <QtTest>
+#include <QStandardPaths>
+
+#include <QtWin/QWApplication.h>
+#include <QtWin/QWThemeManager.h>
+#include <QtWin/QWWindow.h>
+
+using namespace QtWin;
+
+namespace {
+
+/** 统计被观察对象自身收到的 PaletteChange 事件。 */
+class PaletteChangeCounter : public QObject {
+public:
+    explicit PaletteChangeCounter(QObject* watched) : m_watched(watched) {
+        watched->installEventFilter(this);
+    }
+
+    int count = 0;
+
+protected:
+    bool eventFilter(QObject* object, QEvent* event) override {
+        if (object == m_watched && event->type() == QEvent::PaletteChange) {
+            ++count;
+        }
+        return false;
+    }
+
+private:
+    QObject* m_watched;
+};
+
+} // namespace
+
+class TestQWWindow : public QObject {
+    Q_OBJECT
+
+private slots:
+    void themeUpdatesAreCoalesced();
+};
+
+void TestQWWindow::themeUpdatesAreCoalesced() {
+    QWWindow window;
+    QCoreApplication::processEvents();
+    PaletteChangeCounter counter(&window);
+
+    int seedSignals = 0;
+    QColor windowColorInSlot;
+    connect(&window, &QWWindow::seedColorChanged, &window, [&](const QColor&) {
+        ++seedSignals;
+        windowColorInSlot = window.palette().color(QPalette::Window);
+    });
+
+    // 同一轮事件循环中的多次修改只应用一次
+    const QColor seed(200, 80, 40);
+    window.setSeedColor(QColor(40, 160, 90));
+    window.setLightTone(75);
+    window.setDarkTone(25);
+    window.setSeedColor(seed);
+    QCOMPARE(counter.count, 0);
+    QCOMPARE(seedSignals, 0);
+
+    QCoreApplication::processEvents();
+    QCOMPARE(counter.count, 1);
+    QCOMPARE(seedSignals, 1);
+    const QPalette expected = QWApplication::instance()->themeManager()->palette(seed, 75, 25, false);
+    QCOMPARE(window.palette().color(QPalette::Window), expected.color(QPalette::Window));
+    // 信号在调色板应用之后发出
+    QCOMPARE(windowColorInSlot, expected.color(QPalette::Window));
+
+    // ThemeBatch：守卫结束时立即应用一次，之后的事件循环不再重复应用
+    {
+        QWWindow::ThemeBatch batch(&window);
+        window.setSeedColor(QColor(19, 149, 192));
+        window.setLightTone(85);
+        window.setDarkTone(15);
+        QCoreApplication::processEvents();
+        QCOMPARE(counter.count, 1);
+    }
+    QCOMPARE(counter.count, 2);
+    QCOMPARE(seedSignals, 2);
+    QCoreApplication::processEvents();
+    QCOMPARE(counter.count, 2);
+
+    // 没有任何变化时不再设置调色板
+    window.setSeedColor(QColor(19, 149, 192));
+    QCoreApplication::processEvents();
+    QCOMPARE(counter.count, 2);
+}
+
+int main(int argc, char* argv[]) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    // 设置与日志写到测试专用目录，不影响真实的用户数据
+    QStandardPaths::setTestModeEnabled(true);
+    QWApplication app(argc, argv, "QtWin", "QtWinWindowTests", "0.0.1");
+    TestQWWindow test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_qwwindow.moc"